@@ -0,0 +1,190 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <asio-udt/acceptor.hh>
+#include <asio-udt/service.hh>
+#include <asio-udt/socket.hh>
+
+// Effect of buffer autotuning over loopback.
+//
+// Usage: autotune memory [on|off] [connections]
+//        autotune throughput [on|off] [MiB] [rounds]
+//
+// memory reports the resident memory per connection pair. throughput
+// transfers over successive connections, the first one teaching the
+// service the path estimates. Emulate a 200ms RTT with:
+//
+//   tc qdisc add dev lo root netem delay 100ms
+
+typedef std::chrono::steady_clock Clock;
+typedef std::vector<std::unique_ptr<boost::asio::ip::udt::socket>> Sockets;
+
+static std::size_t const memory_cap = std::size_t(4) << 30;
+
+static
+std::size_t
+resident()
+{
+  std::ifstream statm("/proc/self/statm");
+  std::size_t size;
+  std::size_t pages;
+  statm >> size >> pages;
+  return pages * ::sysconf(_SC_PAGESIZE);
+}
+
+static
+void
+check(boost::system::error_code const& error, char const* what)
+{
+  if (error)
+  {
+    std::cerr << what << " error: " << error.message() << std::endl;
+    std::abort();
+  }
+}
+
+// Connect n socket pairs over loopback.
+static
+void
+connect(boost::asio::io_service& io_service,
+        boost::asio::ip::udt::acceptor& acceptor, int port, int n,
+        Sockets& clients, Sockets& servers)
+{
+  std::function<void ()> accept = [&] ()
+    {
+      acceptor.async_accept(
+        [&] (boost::system::error_code const& error,
+             boost::asio::ip::udt::socket* socket)
+        {
+          check(error, "accept");
+          servers.emplace_back(socket);
+          if (static_cast<int>(servers.size()) < n)
+            accept();
+        });
+    };
+  accept();
+  unsigned long ip = (127 << 24) + 1;
+  for (int i = 0; i < n; ++i)
+  {
+    clients.emplace_back(new boost::asio::ip::udt::socket(io_service));
+    clients.back()->async_connect(
+      boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4(ip), port),
+      [] (boost::system::error_code const& error)
+      {
+        check(error, "connection");
+      });
+  }
+  io_service.run();
+  io_service.reset();
+}
+
+static
+void
+memory(boost::asio::io_service& io_service, int connections)
+{
+  boost::asio::ip::udt::acceptor acceptor(io_service, 4270);
+  auto before = resident();
+  Sockets clients;
+  Sockets servers;
+  connect(io_service, acceptor, 4270, connections, clients, servers);
+  auto after = resident();
+  std::cout << connections << " connections: "
+            << (after - before) / connections / 1024
+            << "KiB resident per connection pair" << std::endl;
+}
+
+static
+void
+throughput(boost::asio::io_service& io_service, std::size_t size, int rounds)
+{
+  boost::asio::ip::udt::acceptor acceptor(io_service, 4271);
+  std::vector<char> out(1 << 20, 'x');
+  std::vector<char> in(1 << 20);
+  for (int round = 0; round < rounds; ++round)
+  {
+    Sockets clients;
+    Sockets servers;
+    connect(io_service, acceptor, 4271, 1, clients, servers);
+    auto& source = *clients.front();
+    auto& sink = *servers.front();
+    std::size_t sent = 0;
+    std::size_t received = 0;
+    std::function<void ()> write = [&] ()
+      {
+        source.async_write_some(
+          boost::asio::buffer(out.data(), std::min(out.size(), size - sent)),
+          [&] (boost::system::error_code const& error, std::size_t n)
+          {
+            check(error, "write");
+            sent += n;
+            if (sent < size)
+              write();
+          });
+      };
+    std::function<void ()> read = [&] ()
+      {
+        sink.async_read_some(
+          boost::asio::buffer(in.data(), in.size()),
+          [&] (boost::system::error_code const& error, std::size_t n)
+          {
+            check(error, "read");
+            received += n;
+            if (received < size)
+              read();
+          });
+      };
+    auto start = Clock::now();
+    write();
+    read();
+    io_service.run();
+    io_service.reset();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      Clock::now() - start).count();
+    std::cout << "round " << round << ": " << size / (1 << 20) << "MiB in "
+              << ms << "ms, "
+              << (ms ? size / 1024 * 1000 / ms / 1024 : 0) << "MiB/s"
+              << std::endl;
+    // Closing records the path estimates for the next round.
+    source.close();
+    sink.close();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    std::string what = argc > 1 ? argv[1] : "memory";
+    bool tune = (argc > 2 ? std::string(argv[2]) : "on") == "on";
+    boost::asio::io_service io_service;
+    auto service = new boost::asio::ip::udt::service(io_service);
+    boost::asio::add_service(io_service, service);
+    if (tune)
+      service->autotune(memory_cap);
+    if (what == "memory")
+      memory(io_service,
+             argc > 3 ? boost::lexical_cast<int>(argv[3]) : 10000);
+    else if (what == "throughput")
+      throughput(io_service,
+                 (argc > 3 ? boost::lexical_cast<std::size_t>(argv[3]) : 256)
+                   << 20,
+                 argc > 4 ? boost::lexical_cast<int>(argv[4]) : 3);
+    else
+    {
+      std::cerr << argv[0] << ": unknown benchmark: " << what << std::endl;
+      return 1;
+    }
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,194 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <asio-udt/acceptor.hh>
+#include <asio-udt/service.hh>
+#include <asio-udt/socket.hh>
+
+// Concurrent transfers sharing a service bandwidth budget: flow i has
+// weight i + 1. Reports each flow throughput against its fair share, the
+// fairness index of weight-normalized throughputs and the budget
+// utilization.
+//
+// Usage: bandwidth [budget in KiB/s] [flows] [seconds]
+
+class Sink
+{
+  public:
+    Sink(boost::asio::io_service& io_service, int port)
+      : _acceptor(io_service, port)
+    {
+      accept();
+    }
+
+  private:
+    void
+    accept()
+    {
+      _acceptor.async_accept(std::bind(&Sink::handle_accept, this,
+                                       std::placeholders::_1,
+                                       std::placeholders::_2));
+    }
+
+    void
+    handle_accept(boost::system::error_code const& error,
+                  boost::asio::ip::udt::socket* socket)
+    {
+      if (error)
+        return;
+      _sockets.emplace_back(socket);
+      read(socket);
+      accept();
+    }
+
+    void
+    read(boost::asio::ip::udt::socket* socket)
+    {
+      socket->async_read_some(boost::asio::buffer(_buffer, sizeof(_buffer)),
+                              std::bind(&Sink::handle_read, this, socket,
+                                        std::placeholders::_1,
+                                        std::placeholders::_2));
+    }
+
+    void
+    handle_read(boost::asio::ip::udt::socket* socket,
+                boost::system::error_code const& error, std::size_t)
+    {
+      if (!error)
+        read(socket);
+    }
+
+    boost::asio::ip::udt::acceptor _acceptor;
+    std::vector<std::unique_ptr<boost::asio::ip::udt::socket>> _sockets;
+    char _buffer[65536];
+};
+
+class Source
+{
+  public:
+    Source(boost::asio::io_service& io_service,
+           boost::asio::ip::udt::service& service,
+           int port, unsigned weight)
+      : _socket(io_service)
+      , _sent(0)
+      , _stopped(false)
+      , _buffer(65536, 'x')
+    {
+      service.weight(&_socket, weight);
+      unsigned long ip = (127 << 24) + 1;
+      _socket.async_connect(boost::asio::ip::udp::endpoint(
+                              boost::asio::ip::address_v4(ip), port),
+                            std::bind(&Source::handle_connected, this,
+                                      std::placeholders::_1));
+    }
+
+    std::size_t
+    sent() const
+    {
+      return _sent;
+    }
+
+    void
+    stop()
+    {
+      _stopped = true;
+      _socket.cancel();
+    }
+
+  private:
+    void
+    handle_connected(boost::system::error_code const& error)
+    {
+      if (error)
+      {
+        std::cerr << "connection error: " << error.message() << std::endl;
+        std::abort();
+      }
+      write();
+    }
+
+    void
+    write()
+    {
+      _socket.async_write_some(boost::asio::buffer(_buffer),
+                               std::bind(&Source::handle_write, this,
+                                         std::placeholders::_1,
+                                         std::placeholders::_2));
+    }
+
+    void
+    handle_write(boost::system::error_code const& error, std::size_t size)
+    {
+      if (_stopped)
+        return;
+      if (error)
+      {
+        std::cerr << "write error: " << error.message() << std::endl;
+        std::abort();
+      }
+      _sent += size;
+      write();
+    }
+
+    boost::asio::ip::udt::socket _socket;
+    std::size_t _sent;
+    bool _stopped;
+    std::string _buffer;
+};
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    std::int64_t budget =
+      (argc > 1 ? boost::lexical_cast<std::int64_t>(argv[1]) : 10240) * 1024;
+    int flows = argc > 2 ? boost::lexical_cast<int>(argv[2]) : 4;
+    int seconds = argc > 3 ? boost::lexical_cast<int>(argv[3]) : 10;
+    boost::asio::io_service io_service;
+    auto service = new boost::asio::ip::udt::service(io_service);
+    boost::asio::add_service(io_service, service);
+    service->bandwidth(budget);
+    Sink sink(io_service, 4245);
+    std::vector<std::unique_ptr<Source>> sources;
+    unsigned weights = 0;
+    for (int i = 0; i < flows; ++i)
+    {
+      sources.emplace_back(new Source(io_service, *service, 4245, i + 1));
+      weights += i + 1;
+    }
+    boost::asio::deadline_timer timer(io_service,
+                                      boost::posix_time::seconds(seconds));
+    timer.async_wait([&] (boost::system::error_code const&)
+                     {
+                       for (auto& source: sources)
+                         source->stop();
+                       io_service.stop();
+                     });
+    io_service.run();
+    double total = 0;
+    double sum = 0;
+    double squares = 0;
+    for (int i = 0; i < flows; ++i)
+    {
+      double rate = double(sources[i]->sent()) / seconds;
+      double share = double(budget) * (i + 1) / weights;
+      std::cout << "flow " << i << " (weight " << i + 1 << "): "
+                << rate / 1024 << "KiB/s, "
+                << 100 * rate / share << "% of its share" << std::endl;
+      total += rate;
+      sum += rate / (i + 1);
+      squares += (rate / (i + 1)) * (rate / (i + 1));
+    }
+    std::cout << "fairness index " << sum * sum / (flows * squares) << ", "
+              << "utilization " << 100 * total / budget << "%" << std::endl;
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,229 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <asio-udt/acceptor.hh>
+#include <asio-udt/broadcast.hh>
+#include <asio-udt/service.hh>
+#include <asio-udt/socket.hh>
+
+// One payload fanned out to many subscribers over loopback, either through
+// a broadcast sharing the payload or with a copy and a write chain per
+// subscriber. Reports the time to deliver all rounds to every subscriber.
+//
+// Usage: broadcast [broadcast|copy] [subscribers] [rounds] [payload size]
+
+typedef std::chrono::steady_clock Clock;
+
+class Subscribers
+{
+  public:
+    Subscribers(boost::asio::io_service& io_service, int port,
+                std::size_t expected)
+      : _acceptor(io_service, port)
+      , _expected(expected)
+      , _received(0)
+    {
+      accept();
+    }
+
+    std::size_t
+    received() const
+    {
+      return _received;
+    }
+
+  private:
+    void
+    accept()
+    {
+      _acceptor.async_accept(std::bind(&Subscribers::handle_accept, this,
+                                       std::placeholders::_1,
+                                       std::placeholders::_2));
+    }
+
+    void
+    handle_accept(boost::system::error_code const& error,
+                  boost::asio::ip::udt::socket* socket)
+    {
+      if (error)
+        return;
+      _sockets.emplace_back(socket);
+      read(socket);
+      accept();
+    }
+
+    void
+    read(boost::asio::ip::udt::socket* socket)
+    {
+      socket->async_read_some(boost::asio::buffer(_buffer, sizeof(_buffer)),
+                              std::bind(&Subscribers::handle_read, this,
+                                        socket,
+                                        std::placeholders::_1,
+                                        std::placeholders::_2));
+    }
+
+    void
+    handle_read(boost::asio::ip::udt::socket* socket,
+                boost::system::error_code const& error, std::size_t size)
+    {
+      if (error)
+        return;
+      _received += size;
+      if (_received == _expected)
+        socket->get_io_service().stop();
+      else
+        read(socket);
+    }
+
+    boost::asio::ip::udt::acceptor _acceptor;
+    std::vector<std::unique_ptr<boost::asio::ip::udt::socket>> _sockets;
+    std::size_t _expected;
+    std::size_t _received;
+    char _buffer[65536];
+};
+
+class Publisher
+{
+  public:
+    Publisher(boost::asio::io_service& io_service, int port,
+              bool copy, int subscribers, int rounds, std::size_t size)
+      : _broadcast(io_service)
+      , _copy(copy)
+      , _rounds(rounds)
+      , _connected(0)
+      , _pending(0)
+      , _payload(std::make_shared<std::vector<char> const>(size, 'x'))
+    {
+      unsigned long ip = (127 << 24) + 1;
+      for (int i = 0; i < subscribers; ++i)
+      {
+        auto socket = new boost::asio::ip::udt::socket(io_service);
+        _sockets.emplace_back(socket);
+        _peers.push_back(socket);
+        socket->async_connect(boost::asio::ip::udp::endpoint(
+                                boost::asio::ip::address_v4(ip), port),
+                              std::bind(&Publisher::handle_connected, this,
+                                        std::placeholders::_1));
+      }
+    }
+
+    Clock::time_point
+    start() const
+    {
+      return _start;
+    }
+
+  private:
+    void
+    handle_connected(boost::system::error_code const& error)
+    {
+      if (error)
+      {
+        std::cerr << "connection error: " << error.message() << std::endl;
+        std::abort();
+      }
+      if (++_connected < _sockets.size())
+        return;
+      _start = Clock::now();
+      publish();
+    }
+
+    void
+    publish()
+    {
+      if (_rounds-- == 0)
+        return;
+      if (!_copy)
+      {
+        _broadcast.async_send(
+          _payload, _peers,
+          [this] (std::vector<boost::system::error_code> const& errors)
+          {
+            for (auto const& error: errors)
+              if (error)
+              {
+                std::cerr << "broadcast error: " << error.message()
+                          << std::endl;
+                std::abort();
+              }
+            publish();
+          });
+        return;
+      }
+      _pending = _peers.size();
+      for (auto socket: _peers)
+      {
+        auto copy = std::make_shared<std::vector<char>>(*_payload);
+        write(socket, copy, 0);
+      }
+    }
+
+    void
+    write(boost::asio::ip::udt::socket* socket,
+          std::shared_ptr<std::vector<char>> copy, std::size_t offset)
+    {
+      socket->async_write_some(
+        boost::asio::buffer(copy->data() + offset, copy->size() - offset),
+        [this, socket, copy, offset] (boost::system::error_code const& error,
+                                      std::size_t size)
+        {
+          if (error)
+          {
+            std::cerr << "write error: " << error.message() << std::endl;
+            std::abort();
+          }
+          if (offset + size < copy->size())
+            return write(socket, copy, offset + size);
+          if (--_pending == 0)
+            publish();
+        });
+    }
+
+    boost::asio::ip::udt::broadcast _broadcast;
+    std::vector<std::unique_ptr<boost::asio::ip::udt::socket>> _sockets;
+    std::vector<boost::asio::ip::udt::socket*> _peers;
+    bool _copy;
+    int _rounds;
+    std::size_t _connected;
+    std::size_t _pending;
+    boost::asio::ip::udt::broadcast::payload _payload;
+    Clock::time_point _start;
+};
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    std::string mode = argc > 1 ? argv[1] : "broadcast";
+    int subscribers = argc > 2 ? boost::lexical_cast<int>(argv[2]) : 100;
+    int rounds = argc > 3 ? boost::lexical_cast<int>(argv[3]) : 100;
+    std::size_t size =
+      argc > 4 ? boost::lexical_cast<std::size_t>(argv[4]) : 65536;
+    if (mode != "broadcast" && mode != "copy")
+    {
+      std::cerr << argv[0] << ": unknown mode: " << mode << std::endl;
+      return 1;
+    }
+    boost::asio::io_service io_service;
+    Subscribers sink(io_service, 4248,
+                     std::size_t(subscribers) * rounds * size);
+    Publisher source(io_service, 4248, mode == "copy",
+                     subscribers, rounds, size);
+    io_service.run();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      Clock::now() - source.start()).count();
+    std::cout << mode << ": " << sink.received() << " bytes to "
+              << subscribers << " subscribers in " << elapsed << "ms, "
+              << (elapsed ? sink.received() / 1024 * 1000 / elapsed : 0)
+              << "KiB/s" << std::endl;
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+}
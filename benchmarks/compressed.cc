@@ -0,0 +1,210 @@
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <asio-udt/acceptor.hh>
+#include <asio-udt/compressed-stream.hh>
+#include <asio-udt/service.hh>
+#include <asio-udt/socket.hh>
+
+// Transfer over loopback with a service bandwidth budget emulating a WAN
+// link, through a plain socket and through a compressed stream, of
+// compressible then incompressible data. Reports the effective
+// throughput, the bytes on the wire and the CPU time spent.
+//
+// Usage: compressed [MiB] [link KiB/s] [worker threads]
+
+typedef std::chrono::steady_clock Clock;
+
+static std::size_t const buffer_size = 1 << 20;
+
+static
+void
+check(boost::system::error_code const& error, char const* what)
+{
+  if (error)
+  {
+    std::cerr << what << " error: " << error.message() << std::endl;
+    std::abort();
+  }
+}
+
+// Push data, size bytes in total, from one stream to the other.
+template <typename Stream>
+class Transfer
+{
+  public:
+    Transfer(Stream& source, Stream& sink,
+             std::vector<char> const& data, std::size_t size)
+      : _source(source)
+      , _sink(sink)
+      , _data(data)
+      , _size(size)
+      , _sent(0)
+      , _received(0)
+      , _in(buffer_size)
+    {
+      write();
+      read();
+    }
+
+  private:
+    void
+    write()
+    {
+      auto offset = _sent % _data.size();
+      _source.async_write_some(
+        boost::asio::buffer(_data.data() + offset,
+                            std::min(_data.size() - offset, _size - _sent)),
+        [this] (boost::system::error_code const& error, std::size_t size)
+        {
+          check(error, "write");
+          _sent += size;
+          if (_sent < _size)
+            write();
+        });
+    }
+
+    void
+    read()
+    {
+      _sink.async_read_some(
+        boost::asio::buffer(_in.data(), _in.size()),
+        [this] (boost::system::error_code const& error, std::size_t size)
+        {
+          check(error, "read");
+          _received += size;
+          if (_received < _size)
+            read();
+        });
+    }
+
+    Stream& _source;
+    Stream& _sink;
+    std::vector<char> const& _data;
+    std::size_t _size;
+    std::size_t _sent;
+    std::size_t _received;
+    std::vector<char> _in;
+};
+
+// Connect a socket pair over loopback.
+static
+void
+connect(boost::asio::io_service& io_service, int port,
+        std::unique_ptr<boost::asio::ip::udt::socket>& client,
+        std::unique_ptr<boost::asio::ip::udt::socket>& server)
+{
+  boost::asio::ip::udt::acceptor acceptor(io_service, port);
+  acceptor.async_accept(
+    [&] (boost::system::error_code const& error,
+         boost::asio::ip::udt::socket* socket)
+    {
+      check(error, "accept");
+      server.reset(socket);
+    });
+  unsigned long ip = (127 << 24) + 1;
+  client.reset(new boost::asio::ip::udt::socket(io_service));
+  client->async_connect(
+    boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4(ip), port),
+    [] (boost::system::error_code const& error)
+    {
+      check(error, "connect");
+    });
+  io_service.run();
+  io_service.reset();
+}
+
+static
+void
+run(std::string const& what, std::vector<char> const& data,
+    std::size_t size, std::int64_t link, int threads, bool compress,
+    int port)
+{
+  boost::asio::io_service io_service;
+  auto service = new boost::asio::ip::udt::service(io_service);
+  boost::asio::add_service(io_service, service);
+  service->bandwidth(link);
+  std::unique_ptr<boost::asio::ip::udt::socket> client;
+  std::unique_ptr<boost::asio::ip::udt::socket> server;
+  connect(io_service, port, client, server);
+  boost::asio::io_service workers;
+  std::unique_ptr<boost::asio::io_service::work> work(
+    new boost::asio::io_service::work(workers));
+  std::vector<std::thread> pool;
+  for (int i = 0; i < threads; ++i)
+    pool.emplace_back([&] { workers.run(); });
+  auto start = Clock::now();
+  auto cpu = std::clock();
+  std::uint64_t wire = size;
+  double ratio = 1;
+  if (compress)
+  {
+    boost::asio::ip::udt::compressed_stream source(*client, workers);
+    boost::asio::ip::udt::compressed_stream sink(*server, workers);
+    Transfer<boost::asio::ip::udt::compressed_stream> transfer(
+      source, sink, data, size);
+    io_service.run();
+    wire = source.wire_bytes();
+    ratio = source.ratio();
+  }
+  else
+  {
+    Transfer<boost::asio::ip::udt::socket> transfer(
+      *client, *server, data, size);
+    io_service.run();
+  }
+  auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  auto cpu_seconds = double(std::clock() - cpu) / CLOCKS_PER_SEC;
+  work.reset();
+  for (auto& thread: pool)
+    thread.join();
+  std::cout << what << ": " << size / elapsed / 1024 << "KiB/s effective, "
+            << wire / (1 << 20) << "MiB on the wire (ratio " << ratio
+            << "), " << cpu_seconds << "s CPU, "
+            << cpu_seconds / elapsed * 100 << "% of a core" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    std::size_t size =
+      (argc > 1 ? boost::lexical_cast<std::size_t>(argv[1]) : 256) << 20;
+    std::int64_t link =
+      (argc > 2 ? boost::lexical_cast<std::int64_t>(argv[2]) : 20480) * 1024;
+    int threads = argc > 3 ? boost::lexical_cast<int>(argv[3]) : 2;
+    // Log-like lines over a small vocabulary compress well, random bytes
+    // do not at all.
+    std::vector<char> text;
+    std::vector<char> noise(buffer_size);
+    std::mt19937 random;
+    char const* words[] = {"GET ", "POST ", "/api/v1/", "users ", "200 ",
+                           "404 ", "latency=", "ms ", "host=", "\n"};
+    while (text.size() < buffer_size)
+    {
+      auto word = words[random() % 10];
+      text.insert(text.end(), word, word + std::strlen(word));
+      text.push_back('0' + random() % 10);
+    }
+    for (auto& c: noise)
+      c = random();
+    run("text, plain", text, size, link, threads, false, 4280);
+    run("text, compressed", text, size, link, threads, true, 4281);
+    run("random, plain", noise, size, link, threads, false, 4282);
+    run("random, compressed", noise, size, link, threads, true, 4283);
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+}
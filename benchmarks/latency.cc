@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <asio-udt/acceptor.hh>
+#include <asio-udt/service.hh>
+#include <asio-udt/socket.hh>
+#include <asio-udt/statistics.hh>
+
+// Ping-pong latency over loopback: the client sends a small message, the
+// server echoes it back, and the round trip time is recorded. The busy mode
+// is threaded with a busy polling reactor; the reactor and UDT threads are
+// pinned to the given CPUs, if any. All runs every mode in turn, reactor
+// statistics then add up across modes.
+//
+// Usage: latency [threaded|polled|shared|busy|all] [rounds] [message size]
+//                [reactor CPU] [UDT CPU]
+
+typedef std::chrono::steady_clock Clock;
+
+class Echo
+{
+  public:
+    Echo(boost::asio::io_service& io_service, int port)
+      : _acceptor(io_service, port)
+      , _socket(nullptr)
+    {
+      _acceptor.async_accept(std::bind(&Echo::handle_accept, this,
+                                       std::placeholders::_1,
+                                       std::placeholders::_2));
+    }
+
+    ~Echo()
+    {
+      delete _socket;
+    }
+
+  private:
+    void
+    handle_accept(boost::system::error_code const& error,
+                  boost::asio::ip::udt::socket* socket)
+    {
+      if (error)
+      {
+        std::cerr << "accept error: " << error.message() << std::endl;
+        std::abort();
+      }
+      _socket = socket;
+      read();
+    }
+
+    void
+    read()
+    {
+      _socket->async_read_some(boost::asio::buffer(_buffer, sizeof(_buffer)),
+                               std::bind(&Echo::handle_read, this,
+                                         std::placeholders::_1,
+                                         std::placeholders::_2));
+    }
+
+    void
+    handle_read(boost::system::error_code const& error, std::size_t size)
+    {
+      if (error == boost::asio::error::eof)
+        return;
+      else if (error)
+      {
+        std::cerr << "server read error: " << error.message() << std::endl;
+        std::abort();
+      }
+      _socket->async_write_some(boost::asio::buffer(_buffer, size),
+                                std::bind(&Echo::handle_write, this,
+                                          std::placeholders::_1,
+                                          std::placeholders::_2));
+    }
+
+    void
+    handle_write(boost::system::error_code const& error, std::size_t)
+    {
+      if (error)
+      {
+        std::cerr << "server write error: " << error.message() << std::endl;
+        std::abort();
+      }
+      read();
+    }
+
+    boost::asio::ip::udt::acceptor _acceptor;
+    boost::asio::ip::udt::socket* _socket;
+    char _buffer[65536];
+};
+
+class Ping
+{
+  public:
+    Ping(boost::asio::io_service& io_service, int port,
+         int rounds, std::size_t size)
+      : _socket(io_service)
+      , _rounds(rounds)
+      , _message(size, 'x')
+      , _received(0)
+    {
+      _latencies.reserve(rounds);
+      unsigned long ip = (127 << 24) + 1;
+      _socket.async_connect(boost::asio::ip::udp::endpoint(
+                              boost::asio::ip::address_v4(ip), port),
+                            std::bind(&Ping::handle_connected, this,
+                                      std::placeholders::_1));
+    }
+
+    std::vector<Clock::duration> const&
+    latencies() const
+    {
+      return _latencies;
+    }
+
+  private:
+    void
+    handle_connected(boost::system::error_code const& error)
+    {
+      if (error)
+      {
+        std::cerr << "connection error: " << error.message() << std::endl;
+        std::abort();
+      }
+      ping();
+    }
+
+    void
+    ping()
+    {
+      _start = Clock::now();
+      _received = 0;
+      _socket.async_write_some(boost::asio::buffer(_message),
+                               std::bind(&Ping::handle_sent, this,
+                                         std::placeholders::_1,
+                                         std::placeholders::_2));
+    }
+
+    void
+    handle_sent(boost::system::error_code const& error, std::size_t)
+    {
+      if (error)
+      {
+        std::cerr << "client write error: " << error.message() << std::endl;
+        std::abort();
+      }
+      pong();
+    }
+
+    void
+    pong()
+    {
+      _socket.async_read_some(boost::asio::buffer(_buffer, sizeof(_buffer)),
+                              std::bind(&Ping::handle_pong, this,
+                                        std::placeholders::_1,
+                                        std::placeholders::_2));
+    }
+
+    void
+    handle_pong(boost::system::error_code const& error, std::size_t size)
+    {
+      if (error)
+      {
+        std::cerr << "client read error: " << error.message() << std::endl;
+        std::abort();
+      }
+      _received += size;
+      if (_received < _message.size())
+        return pong();
+      _latencies.push_back(Clock::now() - _start);
+      if (static_cast<int>(_latencies.size()) < _rounds)
+        ping();
+      else
+        _socket.close();
+    }
+
+    boost::asio::ip::udt::socket _socket;
+    int _rounds;
+    std::string _message;
+    std::size_t _received;
+    Clock::time_point _start;
+    std::vector<Clock::duration> _latencies;
+    char _buffer[65536];
+};
+
+static
+void
+report(std::string const& mode, std::vector<Clock::duration> latencies)
+{
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&] (double p)
+    {
+      auto index = static_cast<std::size_t>(p * (latencies.size() - 1));
+      return std::chrono::duration_cast<std::chrono::microseconds>(
+        latencies[index]).count();
+    };
+  std::cout << mode << ": " << latencies.size() << " round trips, "
+            << "p50 " << percentile(0.5) << "us, "
+            << "p90 " << percentile(0.9) << "us, "
+            << "p99 " << percentile(0.99) << "us, "
+            << "p99.9 " << percentile(0.999) << "us, "
+            << "max " << percentile(1) << "us" << std::endl;
+  auto stats = boost::asio::ip::udt::statistics::snapshot();
+  std::cout << "  " << stats.wakeups << " wakeups, "
+            << stats.events.mean() << " events per wakeup, "
+            << "dispatch delay p50 " << stats.dispatch_delay.percentile(0.5)
+            << "ns p99 " << stats.dispatch_delay.percentile(0.99) << "ns, "
+            << "lock wait p99 " << stats.lock_wait.percentile(0.99) << "ns, "
+            << stats.immediate << " immediate and "
+            << stats.deferred << " deferred completions" << std::endl;
+}
+
+static
+void
+run(std::string const& mode, int port, int rounds, std::size_t size,
+    int reactor_cpu, int udt_cpu)
+{
+  boost::asio::io_service io_service;
+  boost::asio::ip::udt::service::mode reactor;
+  if (mode == "threaded" || mode == "busy")
+    reactor = boost::asio::ip::udt::service::threaded;
+  else if (mode == "polled")
+    reactor = boost::asio::ip::udt::service::polled;
+  else
+    reactor = boost::asio::ip::udt::service::shared;
+  auto service = new boost::asio::ip::udt::service(io_service, reactor);
+  boost::asio::add_service(io_service, service);
+  if (mode == "busy")
+    service->busy_poll(std::chrono::microseconds(200));
+  service->affinity(reactor_cpu);
+  service->udt_affinity(udt_cpu);
+  Echo server(io_service, port);
+  Ping client(io_service, port, rounds, size);
+  io_service.run();
+  report(mode, client.latencies());
+}
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    std::string mode = argc > 1 ? argv[1] : "threaded";
+    int rounds = argc > 2 ? boost::lexical_cast<int>(argv[2]) : 10000;
+    std::size_t size =
+      argc > 3 ? boost::lexical_cast<std::size_t>(argv[3]) : 64;
+    int reactor_cpu = argc > 4 ? boost::lexical_cast<int>(argv[4]) : -1;
+    int udt_cpu = argc > 5 ? boost::lexical_cast<int>(argv[5]) : -1;
+    std::vector<std::string> modes{"threaded", "polled", "shared", "busy"};
+    if (mode != "all")
+    {
+      if (std::find(modes.begin(), modes.end(), mode) == modes.end())
+      {
+        std::cerr << argv[0] << ": unknown mode: " << mode << std::endl;
+        return 1;
+      }
+      modes = {mode};
+    }
+    int port = 4243;
+    for (auto const& m: modes)
+      run(m, port++, rounds, size, reactor_cpu, udt_cpu);
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+}
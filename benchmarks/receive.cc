@@ -0,0 +1,236 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <asio-udt/acceptor.hh>
+#include <asio-udt/service.hh>
+#include <asio-udt/socket.hh>
+
+// Many connections streaming to one server, which reads either into one
+// buffer per socket or into slabs of the service buffer pool.
+//
+// Usage: receive [socket|pool] [connections] [messages] [message size]
+
+typedef std::chrono::steady_clock Clock;
+
+static std::size_t const buffer_size = 65536;
+static std::size_t const pool_slabs = 64;
+
+class Server
+{
+  public:
+    Server(boost::asio::io_service& io_service, int port,
+           bool pool, std::size_t expected)
+      : _io_service(io_service)
+      , _acceptor(io_service, port)
+      , _pool(pool)
+      , _expected(expected)
+      , _received(0)
+    {
+      accept();
+    }
+
+    ~Server()
+    {
+      for (auto connection: _connections)
+        delete connection;
+    }
+
+    std::size_t
+    connections() const
+    {
+      return _connections.size();
+    }
+
+  private:
+    struct Connection
+    {
+      Connection(boost::asio::ip::udt::socket* socket, bool pool)
+        : socket(socket)
+        , buffer(pool ? nullptr : new char[buffer_size])
+      {}
+
+      std::unique_ptr<boost::asio::ip::udt::socket> socket;
+      std::unique_ptr<char[]> buffer;
+    };
+
+    void
+    accept()
+    {
+      _acceptor.async_accept(std::bind(&Server::handle_accept, this,
+                                       std::placeholders::_1,
+                                       std::placeholders::_2));
+    }
+
+    void
+    handle_accept(boost::system::error_code const& error,
+                  boost::asio::ip::udt::socket* socket)
+    {
+      if (error)
+      {
+        std::cerr << "accept error: " << error.message() << std::endl;
+        std::abort();
+      }
+      auto connection = new Connection(socket, _pool);
+      _connections.push_back(connection);
+      read(connection);
+      accept();
+    }
+
+    void
+    read(Connection* connection)
+    {
+      if (_pool)
+        connection->socket->async_receive(
+          std::bind(&Server::handle_receive, this, connection,
+                    std::placeholders::_1, std::placeholders::_2));
+      else
+        connection->socket->async_read_some(
+          boost::asio::buffer(connection->buffer.get(), buffer_size),
+          std::bind(&Server::handle_read, this, connection,
+                    std::placeholders::_1, std::placeholders::_2));
+    }
+
+    void
+    handle_receive(Connection* connection,
+                   boost::system::error_code const& error,
+                   boost::asio::ip::udt::buffer_pool::slab slab)
+    {
+      // All slabs are held by other reads: try again later.
+      if (error == boost::asio::error::no_buffer_space)
+        return read(connection);
+      handle_read(connection, error, slab.size());
+    }
+
+    void
+    handle_read(Connection* connection,
+                boost::system::error_code const& error, std::size_t size)
+    {
+      if (error == boost::asio::error::eof)
+        return;
+      else if (error)
+      {
+        std::cerr << "read error: " << error.message() << std::endl;
+        std::abort();
+      }
+      _received += size;
+      if (_received == _expected)
+        _io_service.stop();
+      else
+        read(connection);
+    }
+
+    boost::asio::io_service& _io_service;
+    boost::asio::ip::udt::acceptor _acceptor;
+    bool _pool;
+    std::size_t _expected;
+    std::size_t _received;
+    std::vector<Connection*> _connections;
+};
+
+class Client
+{
+  public:
+    Client(boost::asio::io_service& io_service, int port,
+           std::string const& message, int messages)
+      : _socket(io_service)
+      , _message(message)
+      , _messages(messages)
+      , _sent(0)
+    {
+      unsigned long ip = (127 << 24) + 1;
+      _socket.async_connect(boost::asio::ip::udp::endpoint(
+                              boost::asio::ip::address_v4(ip), port),
+                            std::bind(&Client::handle_connected, this,
+                                      std::placeholders::_1));
+    }
+
+  private:
+    void
+    handle_connected(boost::system::error_code const& error)
+    {
+      if (error)
+      {
+        std::cerr << "connection error: " << error.message() << std::endl;
+        std::abort();
+      }
+      write();
+    }
+
+    void
+    write()
+    {
+      std::size_t offset = _sent % _message.size();
+      _socket.async_write_some(
+        boost::asio::buffer(_message.data() + offset,
+                            _message.size() - offset),
+        std::bind(&Client::handle_write, this,
+                  std::placeholders::_1, std::placeholders::_2));
+    }
+
+    void
+    handle_write(boost::system::error_code const& error, std::size_t size)
+    {
+      if (error)
+      {
+        std::cerr << "write error: " << error.message() << std::endl;
+        std::abort();
+      }
+      _sent += size;
+      if (_sent < _message.size() * _messages)
+        write();
+    }
+
+    boost::asio::ip::udt::socket _socket;
+    std::string const& _message;
+    int _messages;
+    std::size_t _sent;
+};
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    std::string mode = argc > 1 ? argv[1] : "socket";
+    int connections = argc > 2 ? boost::lexical_cast<int>(argv[2]) : 1000;
+    int messages = argc > 3 ? boost::lexical_cast<int>(argv[3]) : 100;
+    std::size_t size =
+      argc > 4 ? boost::lexical_cast<std::size_t>(argv[4]) : 1024;
+    if (mode != "socket" && mode != "pool")
+    {
+      std::cerr << argv[0] << ": unknown mode: " << mode << std::endl;
+      return 1;
+    }
+    bool pool = mode == "pool";
+    boost::asio::io_service io_service;
+    auto service = new boost::asio::ip::udt::service(io_service);
+    boost::asio::add_service(io_service, service);
+    service->buffers(buffer_size, pool_slabs);
+    std::string message(size, 'x');
+    Server server(io_service, 4244, pool, size * messages * connections);
+    std::vector<std::unique_ptr<Client>> clients;
+    for (int i = 0; i < connections; ++i)
+      clients.emplace_back(new Client(io_service, 4244, message, messages));
+    auto start = Clock::now();
+    io_service.run();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      Clock::now() - start).count();
+    std::size_t memory = pool
+      ? buffer_size * pool_slabs
+      : buffer_size * server.connections();
+    std::cout << mode << ": " << server.connections() << " connections, "
+              << size * messages * connections / 1024 << "KiB in "
+              << elapsed << "ms, "
+              << memory / 1024 << "KiB of receive buffers, "
+              << service->buffers().exhaustions() << " pool exhaustions"
+              << std::endl;
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+}
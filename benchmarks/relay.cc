@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <asio-udt/acceptor.hh>
+#include <asio-udt/service.hh>
+#include <asio-udt/socket.hh>
+#include <asio-udt/statistics.hh>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Relay from a pipe to a UDT socket over loopback, as a proxy forwarding a
+// kernel stream would. A thread feeds the pipe; the relay waits for it to be
+// readable either on the UDT service reactor, along with the UDT socket, or
+// on an asio descriptor, that is on the io_service reactor.
+//
+// Usage: relay [reactor|asio|all] [MiB] [chunk size]
+
+typedef std::chrono::steady_clock Clock;
+
+static
+void
+check(boost::system::error_code const& error, char const* what)
+{
+  if (error)
+  {
+    std::cerr << what << " error: " << error.message() << std::endl;
+    std::abort();
+  }
+}
+
+class Sink
+{
+  public:
+    Sink(boost::asio::io_service& io_service, int port)
+      : _acceptor(io_service, port)
+      , _received(0)
+      , _buffer(1 << 20)
+    {
+      _acceptor.async_accept(
+        [this] (boost::system::error_code const& error,
+                boost::asio::ip::udt::socket* socket)
+        {
+          check(error, "accept");
+          _socket.reset(socket);
+          read();
+        });
+    }
+
+    std::size_t
+    received() const
+    {
+      return _received;
+    }
+
+    Clock::time_point
+    end() const
+    {
+      return _end;
+    }
+
+  private:
+    void
+    read()
+    {
+      _socket->async_read_some(
+        boost::asio::buffer(_buffer),
+        [this] (boost::system::error_code const& error, std::size_t size)
+        {
+          if (error == boost::asio::error::eof)
+          {
+            _end = Clock::now();
+            _socket->close();
+            return;
+          }
+          check(error, "sink read");
+          _received += size;
+          read();
+        });
+    }
+
+    boost::asio::ip::udt::acceptor _acceptor;
+    std::unique_ptr<boost::asio::ip::udt::socket> _socket;
+    std::size_t _received;
+    std::vector<char> _buffer;
+    Clock::time_point _end;
+};
+
+// Forward the pipe to a UDT socket. Wait is how readiness of the pipe is
+// awaited.
+class Relay
+{
+  public:
+    typedef std::function<void (std::function<
+                                  void (boost::system::error_code const&)>)>
+      Wait;
+
+    Relay(boost::asio::io_service& io_service, int port, int fd,
+          Wait const& wait, std::size_t chunk)
+      : _socket(io_service)
+      , _fd(fd)
+      , _wait(wait)
+      , _buffer(chunk)
+      , _size(0)
+      , _written(0)
+    {
+      unsigned long ip = (127 << 24) + 1;
+      _socket.async_connect(
+        boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4(ip), port),
+        [this] (boost::system::error_code const& error)
+        {
+          check(error, "connect");
+          pump();
+        });
+    }
+
+  private:
+    void
+    pump()
+    {
+      auto size = ::read(_fd, _buffer.data(), _buffer.size());
+      if (size == 0)
+        return _socket.async_shutdown(
+          boost::asio::ip::udt::socket::shutdown_send,
+          [this] (boost::system::error_code const& error)
+          {
+            check(error, "shutdown");
+            _socket.close();
+          });
+      if (size < 0)
+      {
+        if (errno != EAGAIN)
+        {
+          std::cerr << "pipe read error: " << ::strerror(errno) << std::endl;
+          std::abort();
+        }
+        return _wait(
+          [this] (boost::system::error_code const& error)
+          {
+            check(error, "pipe wait");
+            pump();
+          });
+      }
+      _size = size;
+      _written = 0;
+      write();
+    }
+
+    void
+    write()
+    {
+      _socket.async_write_some(
+        boost::asio::buffer(_buffer.data() + _written, _size - _written),
+        [this] (boost::system::error_code const& error, std::size_t size)
+        {
+          check(error, "relay write");
+          _written += size;
+          if (_written < _size)
+            write();
+          else
+            pump();
+        });
+    }
+
+    boost::asio::ip::udt::socket _socket;
+    int _fd;
+    Wait _wait;
+    std::vector<char> _buffer;
+    std::size_t _size;
+    std::size_t _written;
+};
+
+static
+void
+run(std::string const& mode, std::size_t total, std::size_t chunk, int port)
+{
+  boost::asio::io_service io_service;
+  int pipe[2];
+  if (::pipe(pipe) == -1)
+    throw std::runtime_error("pipe failed");
+  ::fcntl(pipe[0], F_SETFL, O_NONBLOCK);
+  auto& service =
+    boost::asio::use_service<boost::asio::ip::udt::service>(io_service);
+  boost::asio::posix::stream_descriptor descriptor(io_service);
+  Relay::Wait wait;
+  if (mode == "reactor")
+    wait = [&] (std::function<void (boost::system::error_code const&)> h)
+      {
+        service.async_wait(pipe[0], boost::asio::socket_base::wait_read, h);
+      };
+  else
+  {
+    descriptor.assign(pipe[0]);
+    wait = [&] (std::function<void (boost::system::error_code const&)> h)
+      {
+        descriptor.async_wait(
+          boost::asio::posix::stream_descriptor::wait_read, h);
+      };
+  }
+  Sink sink(io_service, port);
+  Relay relay(io_service, port, pipe[0], wait, chunk);
+  auto start = Clock::now();
+  std::thread feeder(
+    [&]
+    {
+      std::vector<char> data(chunk, 'x');
+      std::size_t fed = 0;
+      while (fed < total)
+      {
+        auto size = ::write(pipe[1], data.data(),
+                            std::min(chunk, total - fed));
+        if (size < 0)
+          break;
+        fed += size;
+      }
+      ::close(pipe[1]);
+    });
+  io_service.run();
+  feeder.join();
+  if (mode == "reactor")
+    ::close(pipe[0]);
+  if (sink.received() != total)
+  {
+    std::cerr << mode << ": received " << sink.received()
+              << " bytes out of " << total << std::endl;
+    std::abort();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+    sink.end() - start).count();
+  auto stats = boost::asio::ip::udt::statistics::snapshot();
+  std::cout << mode << ": " << total / double(elapsed) << " MB/s, "
+            << stats.wakeups << " reactor wakeups, "
+            << stats.events.mean() << " events per wakeup, "
+            << "dispatch delay p50 " << stats.dispatch_delay.percentile(0.5)
+            << "ns p99 " << stats.dispatch_delay.percentile(0.99) << "ns"
+            << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    std::string mode = argc > 1 ? argv[1] : "all";
+    std::size_t size =
+      (argc > 2 ? boost::lexical_cast<std::size_t>(argv[2]) : 256) << 20;
+    std::size_t chunk =
+      argc > 3 ? boost::lexical_cast<std::size_t>(argv[3]) : 65536;
+    std::vector<std::string> modes{"reactor", "asio"};
+    if (mode != "all")
+    {
+      if (std::find(modes.begin(), modes.end(), mode) == modes.end())
+      {
+        std::cerr << argv[0] << ": unknown mode: " << mode << std::endl;
+        return 1;
+      }
+      modes = {mode};
+    }
+    int port = 4290;
+    for (auto const& m: modes)
+      run(m, size, chunk, port++);
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+}
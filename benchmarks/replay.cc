@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <asio-udt/recorder.hh>
+#include <asio-udt/replay.hh>
+
+// Replay a reactor trace, as saved by the wakeup benchmark or any service
+// with a recorder, against the reactor of this build: compare the figures
+// of two builds on the same trace. A last round records the replay, to
+// compare the epoll refreshes it issues with the traced ones.
+//
+// Usage: replay trace [rounds]
+
+typedef boost::asio::ip::udt::recorder recorder;
+
+static
+std::size_t
+count(std::vector<recorder::event> const& events, recorder::kind kind)
+{
+  std::size_t res = 0;
+  for (auto const& e: events)
+    if (e.kind == kind)
+      ++res;
+  return res;
+}
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    if (argc < 2)
+    {
+      std::cerr << "usage: " << argv[0] << " trace [rounds]" << std::endl;
+      return 1;
+    }
+    int rounds = argc > 2 ? boost::lexical_cast<int>(argv[2]) : 10;
+    boost::asio::ip::udt::replay replay(recorder::load(argv[1]));
+    auto const& events = replay.events();
+    if (events.empty())
+    {
+      std::cerr << argv[0] << ": empty trace" << std::endl;
+      return 1;
+    }
+    std::cout << "trace: " << events.size() << " events over "
+              << (events.back().time - events.front().time) / 1000000
+              << "ms, " << count(events, recorder::registration)
+              << " registrations, " << count(events, recorder::cancellation)
+              << " cancellations, " << count(events, recorder::wakeup)
+              << " wakeups, " << count(events, recorder::refresh)
+              << " refreshes" << std::endl;
+    for (int i = 0; i < rounds; ++i)
+    {
+      auto res = replay.run();
+      auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        res.elapsed).count();
+      std::cout << "round " << i << ": " << elapsed / 1000 << "us, "
+                << (res.wakeups ? elapsed / res.wakeups : 0)
+                << "ns per wakeup, "
+                << events.size() * 1e9 / std::max<std::int64_t>(elapsed, 1)
+                << " events per second, " << res.ready << " ready, "
+                << res.lost << " lost" << std::endl;
+    }
+    auto record = std::make_shared<recorder>(events.size() * 2);
+    replay.run(record);
+    std::cout << "refreshes: " << count(events, recorder::refresh)
+              << " traced, " << count(record->events(), recorder::refresh)
+              << " replayed" << std::endl;
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,188 @@
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <asio-udt/acceptor.hh>
+#include <asio-udt/service.hh>
+#include <asio-udt/socket.hh>
+#include <asio-udt/striped-stream.hh>
+
+// Bulk transfer over loopback through a single socket, then through
+// striped streams of 1 to 8 connections.
+//
+// Usage: striped [MiB] [max connections]
+
+typedef std::chrono::steady_clock Clock;
+
+static std::size_t const buffer_size = 1 << 20;
+
+// Push size bytes from one stream to the other.
+template <typename Stream>
+class Transfer
+{
+  public:
+    Transfer(Stream& source, Stream& sink, std::size_t size)
+      : _source(source)
+      , _sink(sink)
+      , _size(size)
+      , _sent(0)
+      , _received(0)
+      , _out(buffer_size, 'x')
+      , _in(buffer_size)
+    {
+      write();
+      read();
+    }
+
+  private:
+    void
+    write()
+    {
+      _source.async_write_some(
+        boost::asio::buffer(_out.data(),
+                            std::min(_out.size(), _size - _sent)),
+        [this] (boost::system::error_code const& error, std::size_t size)
+        {
+          check(error, "write");
+          _sent += size;
+          if (_sent < _size)
+            write();
+        });
+    }
+
+    void
+    read()
+    {
+      _sink.async_read_some(
+        boost::asio::buffer(_in.data(), _in.size()),
+        [this] (boost::system::error_code const& error, std::size_t size)
+        {
+          check(error, "read");
+          _received += size;
+          if (_received < _size)
+            read();
+          else
+            // Striped streams keep receiving in the background.
+            _sink.get_io_service().stop();
+        });
+    }
+
+    static
+    void
+    check(boost::system::error_code const& error, char const* what)
+    {
+      if (error)
+      {
+        std::cerr << what << " error: " << error.message() << std::endl;
+        std::abort();
+      }
+    }
+
+    Stream& _source;
+    Stream& _sink;
+    std::size_t _size;
+    std::size_t _sent;
+    std::size_t _received;
+    std::string _out;
+    std::vector<char> _in;
+};
+
+typedef std::vector<std::unique_ptr<boost::asio::ip::udt::socket>> Sockets;
+
+// Connect n socket pairs over loopback.
+static
+void
+connect(boost::asio::io_service& io_service, int port, int n,
+        Sockets& clients, Sockets& servers)
+{
+  boost::asio::ip::udt::acceptor acceptor(io_service, port);
+  std::function<void ()> accept = [&] ()
+    {
+      acceptor.async_accept(
+        [&] (boost::system::error_code const& error,
+             boost::asio::ip::udt::socket* socket)
+        {
+          if (error)
+          {
+            std::cerr << "accept error: " << error.message() << std::endl;
+            std::abort();
+          }
+          servers.emplace_back(socket);
+          if (static_cast<int>(servers.size()) < n)
+            accept();
+        });
+    };
+  accept();
+  unsigned long ip = (127 << 24) + 1;
+  for (int i = 0; i < n; ++i)
+  {
+    clients.emplace_back(new boost::asio::ip::udt::socket(io_service));
+    clients.back()->async_connect(
+      boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4(ip), port),
+      [] (boost::system::error_code const& error)
+      {
+        if (error)
+        {
+          std::cerr << "connection error: " << error.message() << std::endl;
+          std::abort();
+        }
+      });
+  }
+  io_service.run();
+  io_service.reset();
+}
+
+static
+void
+report(std::string const& what, std::size_t size, Clock::duration elapsed)
+{
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+    elapsed).count();
+  std::cout << what << ": " << size / (1 << 20) << "MiB in " << ms << "ms, "
+            << (ms ? size / 1024 * 1000 / ms / 1024 : 0) << "MiB/s"
+            << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    std::size_t size =
+      (argc > 1 ? boost::lexical_cast<std::size_t>(argv[1]) : 1024) << 20;
+    int max = argc > 2 ? boost::lexical_cast<int>(argv[2]) : 8;
+    {
+      boost::asio::io_service io_service;
+      Sockets clients;
+      Sockets servers;
+      connect(io_service, 4250, 1, clients, servers);
+      auto start = Clock::now();
+      Transfer<boost::asio::ip::udt::socket> transfer(
+        *clients.front(), *servers.front(), size);
+      io_service.run();
+      report("single socket", size, Clock::now() - start);
+    }
+    for (int n = 1; n <= max; ++n)
+    {
+      boost::asio::io_service io_service;
+      Sockets clients;
+      Sockets servers;
+      connect(io_service, 4250 + n, n, clients, servers);
+      boost::asio::ip::udt::striped_stream source(std::move(clients));
+      boost::asio::ip::udt::striped_stream sink(std::move(servers));
+      auto start = Clock::now();
+      Transfer<boost::asio::ip::udt::striped_stream> transfer(
+        source, sink, size);
+      io_service.run();
+      report("striped over " + std::to_string(n), size, Clock::now() - start);
+    }
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,166 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <asio-udt/acceptor.hh>
+#include <asio-udt/checksum.hh>
+#include <asio-udt/file-transfer.hh>
+#include <asio-udt/socket.hh>
+
+// File transfer over loopback: measures the checksum stage alone, a full
+// transfer, and a transfer resumed after losing the second half of the
+// received file.
+//
+// Usage: transfer [size in MiB] [chunk size in KiB] [directory]
+
+typedef std::chrono::steady_clock Clock;
+
+static
+double
+seconds(Clock::duration d)
+{
+  return std::chrono::duration<double>(d).count();
+}
+
+static
+void
+generate(std::string const& path, std::uint64_t size)
+{
+  std::ofstream file(path, std::ios::binary);
+  std::mt19937_64 random;
+  std::vector<std::uint64_t> block(1 << 17);
+  for (std::uint64_t written = 0; written < size;)
+  {
+    for (auto& word: block)
+      word = random();
+    auto n = std::min<std::uint64_t>(block.size() * 8, size - written);
+    file.write(reinterpret_cast<char const*>(block.data()), n);
+    written += n;
+  }
+}
+
+static
+void
+checksum(std::string const& path, std::size_t chunk)
+{
+  std::ifstream file(path, std::ios::binary);
+  std::vector<char> buffer(chunk);
+  std::uint64_t total = 0;
+  Clock::duration crc(0);
+  auto start = Clock::now();
+  while (file.read(buffer.data(), buffer.size()) || file.gcount())
+  {
+    auto before = Clock::now();
+    boost::asio::ip::udt::crc32c(buffer.data(), file.gcount());
+    crc += Clock::now() - before;
+    total += file.gcount();
+  }
+  auto elapsed = Clock::now() - start;
+  std::cout << "checksum ("
+            << (boost::asio::ip::udt::crc32c_accelerated() ?
+                "sse4.2" : "software")
+            << "): " << total / seconds(crc) / (1 << 20) << "MiB/s, "
+            << "with disk reads " << total / seconds(elapsed) / (1 << 20)
+            << "MiB/s" << std::endl;
+}
+
+static
+void
+transfer(std::string const& name, std::string const& source,
+         std::string const& destination, std::size_t chunk)
+{
+  boost::asio::io_service io_service;
+  // Disk accesses and checksums of both ends.
+  boost::asio::io_service workers;
+  std::unique_ptr<boost::asio::io_service::work> work(
+    new boost::asio::io_service::work(workers));
+  std::thread worker([&] { workers.run(); });
+  boost::asio::ip::udt::acceptor acceptor(io_service, 4252);
+  std::unique_ptr<boost::asio::ip::udt::socket> server;
+  std::unique_ptr<boost::asio::ip::udt::file_transfer> receiver;
+  boost::asio::ip::udt::socket client(io_service);
+  boost::asio::ip::udt::file_transfer sender(client, workers, source, chunk);
+  auto check = [] (char const* what, boost::system::error_code const& error)
+    {
+      if (error)
+      {
+        std::cerr << what << " error: " << error.message() << std::endl;
+        std::abort();
+      }
+    };
+  std::uint64_t received = 0;
+  acceptor.async_accept(
+    [&] (boost::system::error_code const& error,
+         boost::asio::ip::udt::socket* socket)
+    {
+      check("accept", error);
+      server.reset(socket);
+      receiver.reset(
+        new boost::asio::ip::udt::file_transfer(*server, workers,
+                                                destination));
+      receiver->async_receive(
+        [&] (boost::system::error_code const& error, std::uint64_t size)
+        {
+          check("receive", error);
+          received = size;
+        });
+    });
+  auto start = Clock::now();
+  unsigned long ip = (127 << 24) + 1;
+  client.async_connect(
+    boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4(ip), 4252),
+    [&] (boost::system::error_code const& error)
+    {
+      check("connect", error);
+      sender.async_send(
+        [&] (boost::system::error_code const& error, std::uint64_t)
+        {
+          check("send", error);
+        });
+    });
+  io_service.run();
+  auto elapsed = Clock::now() - start;
+  work.reset();
+  worker.join();
+  std::cout << name << ": " << received / (1 << 20) << "MiB in "
+            << seconds(elapsed) << "s, "
+            << received / seconds(elapsed) / (1 << 20) << "MiB/s, "
+            << receiver->skipped() / (1 << 20) << "MiB skipped" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    std::uint64_t size =
+      (argc > 1 ? boost::lexical_cast<std::uint64_t>(argv[1]) : 2048) << 20;
+    std::size_t chunk =
+      (argc > 2 ? boost::lexical_cast<std::size_t>(argv[2]) : 1024) << 10;
+    std::string directory = argc > 3 ? argv[3] : "/tmp";
+    auto source = directory + "/asio-udt-transfer.source";
+    auto destination = directory + "/asio-udt-transfer.destination";
+    generate(source, size);
+    std::remove(destination.c_str());
+    checksum(source, chunk);
+    transfer("full", source, destination, chunk);
+    if (::truncate(destination.c_str(), size / 2) != 0)
+      throw std::runtime_error("unable to truncate " + destination);
+    transfer("resumed", source, destination, chunk);
+    std::remove(source.c_str());
+    std::remove(destination.c_str());
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <asio-udt/acceptor.hh>
+#include <asio-udt/recorder.hh>
+#include <asio-udt/service.hh>
+#include <asio-udt/socket.hh>
+#include <asio-udt/statistics.hh>
+
+// Many sockets becoming ready at once: every round, each client sends one
+// byte that the server echoes, and the next round starts once all echoes
+// are back. The reactor activity is saved to the trace file, if any, for
+// the replay benchmark.
+//
+// Usage: wakeup [batch size] [sockets] [rounds] [threads] [trace]
+
+typedef std::chrono::steady_clock Clock;
+
+class Echo
+{
+  public:
+    Echo(boost::asio::io_service& io_service, int port)
+      : _acceptor(io_service, port)
+    {
+      accept();
+    }
+
+  private:
+    struct Peer
+    {
+      std::unique_ptr<boost::asio::ip::udt::socket> socket;
+      char byte;
+    };
+
+    void
+    accept()
+    {
+      _acceptor.async_accept(std::bind(&Echo::handle_accept, this,
+                                       std::placeholders::_1,
+                                       std::placeholders::_2));
+    }
+
+    void
+    handle_accept(boost::system::error_code const& error,
+                  boost::asio::ip::udt::socket* socket)
+    {
+      if (error)
+        return;
+      _peers.emplace_back(new Peer{
+          std::unique_ptr<boost::asio::ip::udt::socket>(socket), 0});
+      read(*_peers.back());
+      accept();
+    }
+
+    void
+    read(Peer& peer)
+    {
+      peer.socket->async_read_some(
+        boost::asio::buffer(&peer.byte, 1),
+        [this, &peer] (boost::system::error_code const& error, std::size_t)
+        {
+          if (error)
+            return;
+          peer.socket->async_write_some(
+            boost::asio::buffer(&peer.byte, 1),
+            [this, &peer] (boost::system::error_code const& error,
+                           std::size_t)
+            {
+              if (!error)
+                read(peer);
+            });
+        });
+    }
+
+    boost::asio::ip::udt::acceptor _acceptor;
+    std::vector<std::unique_ptr<Peer>> _peers;
+};
+
+class Clients
+{
+  public:
+    Clients(boost::asio::io_service& io_service, int port,
+            int sockets, int rounds)
+      : _io_service(io_service)
+      , _rounds(rounds)
+      , _round(0)
+      , _pending(sockets)
+      , _bytes(sockets)
+    {
+      unsigned long ip = (127 << 24) + 1;
+      for (int i = 0; i < sockets; ++i)
+      {
+        _sockets.emplace_back(new boost::asio::ip::udt::socket(io_service));
+        _sockets.back()->async_connect(
+          boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4(ip),
+                                         port),
+          [this] (boost::system::error_code const& error)
+          {
+            if (error)
+            {
+              std::cerr << "connection error: " << error.message()
+                        << std::endl;
+              std::abort();
+            }
+            if (--_pending == 0)
+              round();
+          });
+      }
+    }
+
+    Clock::time_point start;
+
+  private:
+    void
+    round()
+    {
+      if (_round++ == 0)
+        start = Clock::now();
+      if (_round > _rounds)
+        return _io_service.stop();
+      _pending = _sockets.size();
+      for (std::size_t i = 0; i < _sockets.size(); ++i)
+        ping(i);
+    }
+
+    void
+    ping(std::size_t i)
+    {
+      static char const byte = 'x';
+      _sockets[i]->async_write_some(
+        boost::asio::buffer(&byte, 1),
+        [this, i] (boost::system::error_code const& error, std::size_t)
+        {
+          if (error)
+            std::abort();
+          _sockets[i]->async_read_some(
+            boost::asio::buffer(&_bytes[i], 1),
+            [this] (boost::system::error_code const& error, std::size_t)
+            {
+              if (error)
+                std::abort();
+              if (--_pending == 0)
+                round();
+            });
+        });
+    }
+
+    boost::asio::io_service& _io_service;
+    int _rounds;
+    int _round;
+    std::atomic<std::size_t> _pending;
+    std::vector<char> _bytes;
+    std::vector<std::unique_ptr<boost::asio::ip::udt::socket>> _sockets;
+};
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    std::size_t batch =
+      argc > 1 ? boost::lexical_cast<std::size_t>(argv[1]) : 0;
+    int sockets = argc > 2 ? boost::lexical_cast<int>(argv[2]) : 500;
+    int rounds = argc > 3 ? boost::lexical_cast<int>(argv[3]) : 1000;
+    int threads = argc > 4 ? boost::lexical_cast<int>(argv[4]) : 4;
+    std::string trace = argc > 5 ? argv[5] : "";
+    boost::asio::io_service io_service;
+    auto service = new boost::asio::ip::udt::service(io_service);
+    boost::asio::add_service(io_service, service);
+    service->batch(batch);
+    auto recorder = std::make_shared<boost::asio::ip::udt::recorder>(1 << 20);
+    if (!trace.empty())
+      service->recorder(recorder);
+    Echo server(io_service, 4260);
+    Clients clients(io_service, 4260, sockets, rounds);
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; ++i)
+      workers.emplace_back([&] { io_service.run(); });
+    io_service.run();
+    for (auto& worker: workers)
+      worker.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      Clock::now() - clients.start).count();
+    auto stats = boost::asio::ip::udt::statistics::snapshot();
+    std::cout << "batch " << batch << ": " << rounds << " rounds of "
+              << sockets << " sockets in " << elapsed / 1000 << "ms, "
+              << elapsed / rounds << "us per round, "
+              << stats.events.mean() << " events per wakeup, "
+              << "dispatch delay p99 " << stats.dispatch_delay.percentile(0.99)
+              << "ns" << std::endl;
+    if (!trace.empty())
+    {
+      recorder->save(trace);
+      std::cout << "saved " << std::min<std::uint64_t>(recorder->recorded(),
+                                                      recorder->capacity())
+                << " of " << recorder->recorded() << " reactor events to "
+                << trace << std::endl;
+    }
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << argv[0] << ": error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -1,3 +1,5 @@
+#include <boost/asio/detail/throw_error.hpp>
+
 #include <asio-udt/acceptor.hh>
 #include <asio-udt/error-category.hh>
 #include <asio-udt/service.hh>
@@ -10,28 +12,74 @@ namespace boost
     {
       namespace udt
       {
-        acceptor::acceptor(io_service& io_service, int port)
+        acceptor::acceptor(io_service& io_service)
           : _service(io_service)
           , _udt_service(use_service<service>(_service))
-          , _port(port)
+          , _port(0)
           , _socket(io_service)
+          , _tuned(0)
+        {}
+
+        acceptor::acceptor(io_service& io_service, int port)
+          : acceptor(io_service)
         {
-          this->_listen(port);
+          this->listen(port);
         }
 
         acceptor::acceptor(io_service& io_service, int port, int fd)
-          : _service(io_service)
-          , _udt_service(use_service<service>(_service))
-          , _port(port)
-          , _socket(io_service)
+          : acceptor(io_service)
         {
-          this->_socket._bind_fd(fd);
+          this->assign(port, fd);
         }
 
-        void
-        acceptor::async_accept(
-          std::function<void (boost::system::error_code const&,
-                              boost::asio::ip::udt::socket*)> const& handler)
+        bool
+        acceptor::_accept(socket*& res, system::error_code& error)
+        {
+          UDTSOCKET fd;
+          socket::endpoint_type endpoint;
+          if (!this->_accept(fd, endpoint, error))
+            return false;
+          if (error)
+            return true;
+          res = new socket(_service, fd, endpoint);
+          res->_setup(error);
+          if (error)
+          {
+            delete res;
+            res = nullptr;
+            return true;
+          }
+          if (this->_tuned)
+            res->_tuned = this->_udt_service._grant(this->_tuned);
+          return true;
+        }
+
+        bool
+        acceptor::_accept(socket& res, system::error_code& error)
+        {
+          auto state = UDT::getsockstate(res._udt_socket);
+          if (state == CONNECTING || state == CONNECTED)
+          {
+            error = boost::asio::error::already_open;
+            return true;
+          }
+          UDTSOCKET fd;
+          socket::endpoint_type endpoint;
+          if (!this->_accept(fd, endpoint, error))
+            return false;
+          if (error)
+            return true;
+          res._assign(fd, endpoint, error);
+          if (error)
+            return true;
+          if (this->_tuned)
+            res._tuned = this->_udt_service._grant(this->_tuned);
+          return true;
+        }
+
+        bool
+        acceptor::_accept(UDTSOCKET& fd, socket::endpoint_type& endpoint,
+                          system::error_code& error)
         {
           sockaddr peer;
           int len;
@@ -41,24 +89,12 @@ namespace boost
           {
             if (UDT::getlasterror().getErrorCode() ==
                 udt_category::EASYNCRCV)
-            {
-              std::function<void ()> action =
-                std::bind(&acceptor::async_accept, this, handler);
-              socket* nullsock = nullptr;
-              system::error_code canceled(system::errc::operation_canceled,
-                                          system::system_category());
-              std::function<void ()> cancel =
-                std::bind(handler,
-                          canceled,
-                          nullsock);
-              _udt_service.register_read(&this->_socket, action, cancel);
-            }
-            else
-              throw_udt();
+              return false;
+            error = udt_error();
           }
           else
           {
-            socket::endpoint_type endpoint;
+            fd = udt_socket;
             if (peer.sa_family == AF_INET)
               // IP v4
               {
@@ -87,22 +123,54 @@ namespace boost
                 auto port = ntohs(peer_v6.sin6_port);
                 endpoint = socket::endpoint_type(v6, port);
               }
-            socket* res(new socket(_service, udt_socket, endpoint));
-            this->_service.post
-              (std::bind(handler, system::error_code(), res));
           }
+          return true;
         }
 
         static const int queue_size = 1024;
 
         void
-        acceptor::_listen(unsigned short port)
+        acceptor::listen(unsigned short port)
+        {
+          system::error_code error;
+          this->listen(port, error);
+          asio::detail::throw_error(error, "listen");
+        }
+
+        void
+        acceptor::listen(unsigned short port, system::error_code& error)
         {
+          // Accepted connections inherit the listener buffers, which can
+          // only be set before binding.
+          this->_tuned = this->_udt_service._tune(this->_socket._udt_socket,
+                                                  nullptr, false);
           // Build the listening endpoint.
-          this->_socket.bind(port);
+          this->_socket.bind(port, error);
+          if (error)
+            return;
           // Listen.
           if (UDT::listen(this->_socket._udt_socket, queue_size) == UDT::ERROR)
-            throw_udt();
+          {
+            error = udt_error();
+            return;
+          }
+          this->_port = port;
+        }
+
+        void
+        acceptor::assign(int port, int fd)
+        {
+          system::error_code error;
+          this->assign(port, fd, error);
+          asio::detail::throw_error(error, "assign");
+        }
+
+        void
+        acceptor::assign(int port, int fd, system::error_code& error)
+        {
+          this->_socket._bind_fd(fd, error);
+          if (!error)
+            this->_port = port;
         }
 
         void
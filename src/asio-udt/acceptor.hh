@@ -1,6 +1,8 @@
 #ifndef ASIO_UDT_ACCEPTOR_HH
 # define ASIO_UDT_ACCEPTOR_HH
 
+# include <utility>
+
 # include <boost/asio.hpp>
 
 # include <asio-udt/fwd.hh>
@@ -17,25 +19,63 @@ namespace boost
         class acceptor
         {
           public:
+            /// An acceptor that does not listen yet, see listen.
+            explicit
+            acceptor(io_service& io_service);
             acceptor(io_service& io_service, int port);
             acceptor(io_service& io_service, int port, int fd);
             void
-            async_accept(std::function<void (boost::system::error_code const&,
-                                             boost::asio::ip::udt::socket*)>
-                         const& handler);
+            listen(unsigned short port);
+            void
+            listen(unsigned short port, system::error_code& error);
+            /// Bind to fd, a UDP socket bound to port, as the constructor
+            /// taking them does.
+            void
+            assign(int port, int fd);
+            void
+            assign(int port, int fd, system::error_code& error);
+            /// Handler is called with the error and the accepted socket,
+            /// which it owns. Any completion token is accepted. Accept
+            /// failures are delivered to the handler, never thrown.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code, socket*))
+            async_accept(Handler&& handler);
+            /// Accept into peer, which must not be connected. Lets callers
+            /// reuse preallocated sockets instead of receiving a new one.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler, void (system::error_code))
+            async_accept(socket& peer, Handler&& handler);
             void
             cancel();
             int
             port() const;
 
           private:
-            void _listen(unsigned short port);
+            /// Accept a pending connection, if any, or fail with error.
+            bool
+            _accept(UDTSOCKET& fd, socket::endpoint_type& endpoint,
+                    system::error_code& error);
+            bool
+            _accept(socket*& peer, system::error_code& error);
+            bool
+            _accept(socket& peer, system::error_code& error);
+            template <typename Handler>
+            void
+            _async_accept(Handler handler, bool deferred);
+            template <typename Handler>
+            void
+            _async_accept(socket& peer, Handler handler, bool deferred);
+            struct _initiate_accept;
+            struct _initiate_accept_into;
 
           private:
             io_service& _service;
             service& _udt_service;
             int _port;
             socket _socket;
+            /// Buffer size accepted connections inherit when autotuning.
+            std::size_t _tuned;
             std::function<void ()> _read_action;
         };
       }
@@ -43,4 +83,6 @@ namespace boost
   }
 }
 
+# include <asio-udt/acceptor.hxx>
+
 #endif
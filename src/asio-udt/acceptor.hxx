@@ -0,0 +1,133 @@
+#ifndef ASIO_UDT_ACCEPTOR_HXX
+# define ASIO_UDT_ACCEPTOR_HXX
+
+# include <memory>
+
+# include <boost/asio/async_result.hpp>
+# include <boost/asio/detail/bind_handler.hpp>
+
+# include <asio-udt/service.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        struct acceptor::_initiate_accept
+        {
+          acceptor* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler) const
+          {
+            this->self->_async_accept(
+              typename std::decay<Handler>::type(
+                std::forward<Handler>(handler)),
+              false);
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, socket*))
+        acceptor::async_accept(Handler&& handler)
+        {
+          return async_initiate<Handler, void (system::error_code, socket*)>(
+            _initiate_accept{this}, handler);
+        }
+
+        template <typename Handler>
+        void
+        acceptor::_async_accept(Handler handler, bool deferred)
+        {
+          socket* peer = nullptr;
+          system::error_code error;
+          if (this->_accept(peer, error))
+          {
+            if (deferred)
+              handler(error, peer);
+            else
+              asio::post(
+                this->_service,
+                asio::detail::bind_handler(std::move(handler),
+                                           error, peer));
+            return;
+          }
+          auto h = std::make_shared<Handler>(std::move(handler));
+          this->_udt_service.register_read
+            (&this->_socket,
+             [this, h] ()
+             {
+               this->_async_accept(std::move(*h), true);
+             },
+             [h] (system::error_code const& error)
+             {
+               (*h)(error, static_cast<socket*>(nullptr));
+             },
+             posix_time::pos_infin,
+             service::invoker(this->_service, h));
+        }
+
+        struct acceptor::_initiate_accept_into
+        {
+          acceptor* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler, socket* peer) const
+          {
+            this->self->_async_accept(
+              *peer,
+              typename std::decay<Handler>::type(
+                std::forward<Handler>(handler)),
+              false);
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler, void (system::error_code))
+        acceptor::async_accept(socket& peer, Handler&& handler)
+        {
+          return async_initiate<Handler, void (system::error_code)>(
+            _initiate_accept_into{this}, handler, &peer);
+        }
+
+        template <typename Handler>
+        void
+        acceptor::_async_accept(socket& peer, Handler handler, bool deferred)
+        {
+          system::error_code error;
+          if (this->_accept(peer, error))
+          {
+            if (deferred)
+              handler(error);
+            else
+              asio::post(
+                this->_service,
+                asio::detail::bind_handler(std::move(handler), error));
+            return;
+          }
+          auto h = std::make_shared<Handler>(std::move(handler));
+          this->_udt_service.register_read
+            (&this->_socket,
+             [this, &peer, h] ()
+             {
+               this->_async_accept(peer, std::move(*h), true);
+             },
+             [h] (system::error_code const& error)
+             {
+               (*h)(error);
+             },
+             posix_time::pos_infin,
+             service::invoker(this->_service, h));
+        }
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include <cstring>
+
+#include <asio-udt/affinity.hh>
+
+#ifdef __linux__
+# include <pthread.h>
+# include <sched.h>
+#endif
+
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("boost.asio.ip.udt.affinity");
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+#ifdef __linux__
+        struct scoped_affinity::Mask
+        {
+          cpu_set_t set;
+        };
+
+        bool
+        pin_thread(int cpu)
+        {
+          if (cpu < 0 || cpu >= CPU_SETSIZE)
+            return false;
+          cpu_set_t set;
+          CPU_ZERO(&set);
+          CPU_SET(cpu, &set);
+          int error = ::pthread_setaffinity_np(::pthread_self(),
+                                               sizeof(set), &set);
+          if (error != 0)
+          {
+            ELLE_WARN("unable to pin thread to CPU %s: %s",
+                      cpu, ::strerror(error));
+            return false;
+          }
+          ELLE_TRACE("pin thread to CPU %s", cpu);
+          return true;
+        }
+
+        scoped_affinity::scoped_affinity(int cpu)
+        {
+          if (cpu < 0)
+            return;
+          std::unique_ptr<Mask> previous(new Mask);
+          int error = ::pthread_getaffinity_np(::pthread_self(),
+                                               sizeof(previous->set),
+                                               &previous->set);
+          if (error != 0)
+          {
+            // The affinity could not be restored: leave it alone.
+            ELLE_WARN("unable to get thread affinity: %s",
+                      ::strerror(error));
+            return;
+          }
+          if (pin_thread(cpu))
+            this->_previous = std::move(previous);
+        }
+
+        scoped_affinity::~scoped_affinity()
+        {
+          if (this->_previous)
+            ::pthread_setaffinity_np(::pthread_self(),
+                                     sizeof(this->_previous->set),
+                                     &this->_previous->set);
+        }
+#else
+        struct scoped_affinity::Mask
+        {};
+
+        bool
+        pin_thread(int)
+        {
+          return false;
+        }
+
+        scoped_affinity::scoped_affinity(int)
+        {}
+
+        scoped_affinity::~scoped_affinity()
+        {}
+#endif
+      }
+    }
+  }
+}
@@ -0,0 +1,40 @@
+#ifndef ASIO_UDT_AFFINITY_HH
+# define ASIO_UDT_AFFINITY_HH
+
+# include <memory>
+
+# include <boost/noncopyable.hpp>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Pin the calling thread to cpu. Return whether it succeeded,
+        /// never on platforms without thread affinity.
+        bool
+        pin_thread(int cpu);
+
+        /// Pin the calling thread to cpu for the lifetime of the guard,
+        /// then restore its previous affinity. Threads created meanwhile
+        /// inherit the pinning. A negative cpu does nothing.
+        class scoped_affinity: public boost::noncopyable
+        {
+          public:
+            explicit
+            scoped_affinity(int cpu);
+            ~scoped_affinity();
+
+          private:
+            struct Mask;
+            std::unique_ptr<Mask> _previous;
+        };
+      }
+    }
+  }
+}
+
+#endif
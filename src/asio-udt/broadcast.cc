@@ -0,0 +1,131 @@
+#include <atomic>
+
+#include <asio-udt/broadcast.hh>
+#include <asio-udt/service.hh>
+
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("boost.asio.ip.udt.broadcast");
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        struct broadcast::Fanout
+        {
+          payload data;
+          /// Peers, which may be destroyed during the broadcast.
+          std::vector<socket::Anchor> peers;
+          /// Bytes written to each peer.
+          std::vector<std::size_t> sent;
+          std::vector<system::error_code> errors;
+          /// Peers not served yet. Peers progress concurrently when the
+          /// io_service runs on several threads.
+          std::atomic<std::size_t> remaining;
+          Done done;
+          /// Keeps the fanout alive until the last peer is served, or until
+          /// it shuts down.
+          service* owner;
+        };
+
+        broadcast::broadcast(io_service& io_service)
+          : _service(io_service)
+        {}
+
+        io_service&
+        broadcast::get_io_service()
+        {
+          return this->_service;
+        }
+
+        void
+        broadcast::_send(payload data, std::vector<socket*> const& sockets,
+                         Done done)
+        {
+          ELLE_TRACE_SCOPE("broadcast %s bytes to %s peers",
+                           data->size(), sockets.size());
+          if (sockets.empty())
+            return done(std::vector<system::error_code>());
+          auto fanout = std::make_shared<Fanout>();
+          fanout->data = std::move(data);
+          for (auto sock: sockets)
+            fanout->peers.push_back(sock->_anchor);
+          fanout->sent.resize(sockets.size(), 0);
+          fanout->errors.resize(sockets.size());
+          fanout->remaining = sockets.size();
+          fanout->done = std::move(done);
+          fanout->owner = &use_service<service>(this->_service);
+          fanout->owner->_retain(fanout);
+          // Peers are written from the io_service, concurrently if it runs
+          // on several threads, rather than on the caller's.
+          for (std::size_t i = 0; i < sockets.size(); ++i)
+          {
+            auto peer = fanout.get();
+            asio::post(this->_service,
+                       [peer, i] ()
+                       {
+                         _write(peer, i);
+                       });
+          }
+        }
+
+        void
+        broadcast::_write(Fanout* fanout, std::size_t i)
+        {
+          auto sock = socket::_anchored(fanout->peers[i]);
+          if (!sock)
+            return _finish(fanout, i, boost::asio::error::operation_aborted);
+          auto& data = *fanout->data;
+          auto& sent = fanout->sent[i];
+          while (sent < data.size())
+          {
+            system::error_code error;
+            std::size_t written = 0;
+            if (!sock->_write_some(
+                  boost::asio::buffer(data.data() + sent, data.size() - sent),
+                  error, written))
+            {
+              // The actions only capture the fanout and the peer index,
+              // which fit in std::function without allocation.
+              sock->_udt_service.register_write
+                (sock,
+                 [fanout, i] ()
+                 {
+                   _write(fanout, i);
+                 },
+                 [fanout, i] (system::error_code const& error)
+                 {
+                   _finish(fanout, i, error);
+                 },
+                 sock->_write_timeout);
+              return;
+            }
+            if (error)
+              return _finish(fanout, i, error);
+            sent += written;
+          }
+          _finish(fanout, i, system::error_code());
+        }
+
+        void
+        broadcast::_finish(Fanout* fanout, std::size_t i,
+                           system::error_code const& error)
+        {
+          if (error)
+            ELLE_TRACE("broadcast to peer %s failed after %s bytes: %s",
+                       i, fanout->sent[i], error.message());
+          fanout->errors[i] = error;
+          if (--fanout->remaining > 0)
+            return;
+          auto keep = fanout->owner->_release(fanout);
+          fanout->data.reset();
+          fanout->done(fanout->errors);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,79 @@
+#ifndef ASIO_UDT_BROADCAST_HH
+# define ASIO_UDT_BROADCAST_HH
+
+# include <functional>
+# include <memory>
+# include <utility>
+# include <vector>
+
+# include <boost/asio.hpp>
+# include <boost/noncopyable.hpp>
+
+# include <asio-udt/fwd.hh>
+# include <asio-udt/socket.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Fan-out of one payload to many sockets.
+        ///
+        /// The payload is shared by all peers instead of copied, and so is
+        /// the progress record of each broadcast: peers only add a posted
+        /// write and, while UDT would block, a reactor registration, but no
+        /// handler of their own.
+        class broadcast: public boost::noncopyable
+        {
+          public:
+            /// Immutable payload, released once every peer consumed it.
+            typedef std::shared_ptr<std::vector<char> const> payload;
+
+          public:
+            explicit
+            broadcast(io_service& io_service);
+
+          public:
+            /// Write data entirely to each of sockets, which must have no
+            /// other write pending. Handler is called once all peers are
+            /// served, with the error of each peer in the order of
+            /// sockets. Peers destroyed meanwhile fail with
+            /// operation_aborted.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(
+              Handler, void (std::vector<system::error_code>))
+            async_send(payload data, std::vector<socket*> const& sockets,
+                       Handler&& handler);
+            io_service&
+            get_io_service();
+
+          private:
+            typedef std::function<
+              void (std::vector<system::error_code> const&)> Done;
+            struct Fanout;
+            struct _initiate_send;
+            void
+            _send(payload data, std::vector<socket*> const& sockets,
+                  Done done);
+            /// Write to peer i of fanout until done or UDT would block.
+            static
+            void
+            _write(Fanout* fanout, std::size_t i);
+            static
+            void
+            _finish(Fanout* fanout, std::size_t i,
+                    system::error_code const& error);
+
+            io_service& _service;
+        };
+      }
+    }
+  }
+}
+
+# include <asio-udt/broadcast.hxx>
+
+#endif
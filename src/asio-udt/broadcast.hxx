@@ -0,0 +1,57 @@
+#ifndef ASIO_UDT_BROADCAST_HXX
+# define ASIO_UDT_BROADCAST_HXX
+
+# include <memory>
+
+# include <boost/asio/async_result.hpp>
+# include <boost/asio/detail/bind_handler.hpp>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        struct broadcast::_initiate_send
+        {
+          broadcast* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler, payload const& data,
+                      std::vector<socket*> const* sockets) const
+          {
+            typedef typename std::decay<Handler>::type Completion;
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            auto& service = this->self->_service;
+            this->self->_send(
+              data, *sockets,
+              [h, &service] (std::vector<system::error_code> const& errors)
+              {
+                asio::post(service,
+                           asio::detail::bind_handler(std::move(*h),
+                                                      errors));
+              });
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(
+          Handler, void (std::vector<system::error_code>))
+        broadcast::async_send(payload data,
+                              std::vector<socket*> const& sockets,
+                              Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (std::vector<system::error_code>)>(
+            _initiate_send{this}, handler, data, &sockets);
+        }
+      }
+    }
+  }
+}
+
+#endif
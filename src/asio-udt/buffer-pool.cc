@@ -0,0 +1,236 @@
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include <asio-udt/buffer-pool.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        struct buffer_pool::impl
+        {
+          impl(std::size_t slab_size, std::size_t count)
+            : slab_size(slab_size)
+            , count(count)
+            , references(1)
+            , exhaustions(0)
+          {}
+
+          /// Allocate the slabs, under lock.
+          void
+          allocate()
+          {
+            this->memory.reset(new char[this->slab_size * this->count]);
+            this->counts.reset(new std::atomic<std::size_t>[this->count]);
+            this->free.reserve(this->count);
+            for (std::size_t i = this->count; i > 0; --i)
+              this->free.push_back(i - 1);
+          }
+
+          void
+          acquire()
+          {
+            this->references.fetch_add(1, std::memory_order_relaxed);
+          }
+
+          void
+          release()
+          {
+            if (this->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+              delete this;
+          }
+
+          std::size_t slab_size;
+          std::size_t count;
+          /// The pool handles plus one per slab handed out.
+          std::atomic<std::size_t> references;
+          std::unique_ptr<char[]> memory;
+          /// Handles on each slab handed out.
+          std::unique_ptr<std::atomic<std::size_t>[]> counts;
+          std::vector<std::size_t> free;
+          std::uint64_t exhaustions;
+          mutable boost::mutex lock;
+        };
+
+        buffer_pool::slab::slab()
+          : _pool(nullptr)
+          , _index(0)
+          , _size(0)
+          , _capacity(0)
+        {}
+
+        buffer_pool::slab::slab(impl* pool, std::size_t index)
+          : _pool(pool)
+          , _index(index)
+          , _size(0)
+          , _capacity(pool->slab_size)
+        {}
+
+        buffer_pool::slab::slab(slab const& source)
+          : _pool(source._pool)
+          , _index(source._index)
+          , _size(source._size)
+          , _capacity(source._capacity)
+        {
+          if (this->_pool)
+            this->_pool->counts[this->_index].fetch_add(
+              1, std::memory_order_relaxed);
+        }
+
+        buffer_pool::slab::slab(slab&& source)
+          : _pool(source._pool)
+          , _index(source._index)
+          , _size(source._size)
+          , _capacity(source._capacity)
+        {
+          source._pool = nullptr;
+          source._size = 0;
+          source._capacity = 0;
+        }
+
+        buffer_pool::slab::~slab()
+        {
+          this->release();
+        }
+
+        buffer_pool::slab&
+        buffer_pool::slab::operator =(slab source)
+        {
+          std::swap(this->_pool, source._pool);
+          std::swap(this->_index, source._index);
+          std::swap(this->_size, source._size);
+          std::swap(this->_capacity, source._capacity);
+          return *this;
+        }
+
+        buffer_pool::slab::operator bool() const
+        {
+          return this->_pool != nullptr;
+        }
+
+        char*
+        buffer_pool::slab::data() const
+        {
+          if (!this->_pool)
+            return nullptr;
+          return this->_pool->memory.get() +
+            this->_index * this->_pool->slab_size;
+        }
+
+        std::size_t
+        buffer_pool::slab::size() const
+        {
+          return this->_size;
+        }
+
+        std::size_t
+        buffer_pool::slab::capacity() const
+        {
+          return this->_capacity;
+        }
+
+        const_buffer
+        buffer_pool::slab::buffer() const
+        {
+          return const_buffer(this->data(), this->_size);
+        }
+
+        void
+        buffer_pool::slab::release()
+        {
+          auto pool = this->_pool;
+          this->_pool = nullptr;
+          this->_size = 0;
+          this->_capacity = 0;
+          if (!pool ||
+              pool->counts[this->_index].fetch_sub(
+                1, std::memory_order_acq_rel) != 1)
+            return;
+          {
+            boost::mutex::scoped_lock lock(pool->lock);
+            pool->free.push_back(this->_index);
+          }
+          // Slabs keep the pool memory alive until they are all back.
+          pool->release();
+        }
+
+        buffer_pool::buffer_pool(std::size_t slab_size, std::size_t count)
+          : _impl(new impl(slab_size, count))
+        {}
+
+        buffer_pool::buffer_pool(buffer_pool const& source)
+          : _impl(source._impl)
+        {
+          this->_impl->acquire();
+        }
+
+        buffer_pool::~buffer_pool()
+        {
+          if (this->_impl)
+            this->_impl->release();
+        }
+
+        buffer_pool&
+        buffer_pool::operator =(buffer_pool source)
+        {
+          std::swap(this->_impl, source._impl);
+          return *this;
+        }
+
+        buffer_pool::slab
+        buffer_pool::acquire()
+        {
+          std::size_t index;
+          {
+            boost::mutex::scoped_lock lock(this->_impl->lock);
+            if (!this->_impl->memory)
+              this->_impl->allocate();
+            if (this->_impl->free.empty())
+            {
+              ++this->_impl->exhaustions;
+              return slab();
+            }
+            index = this->_impl->free.back();
+            this->_impl->free.pop_back();
+          }
+          this->_impl->counts[index].store(1, std::memory_order_relaxed);
+          this->_impl->acquire();
+          return slab(this->_impl, index);
+        }
+
+        std::size_t
+        buffer_pool::slab_size() const
+        {
+          return this->_impl->slab_size;
+        }
+
+        std::size_t
+        buffer_pool::count() const
+        {
+          return this->_impl->count;
+        }
+
+        std::size_t
+        buffer_pool::in_use() const
+        {
+          boost::mutex::scoped_lock lock(this->_impl->lock);
+          if (!this->_impl->memory)
+            return 0;
+          return this->_impl->count - this->_impl->free.size();
+        }
+
+        std::uint64_t
+        buffer_pool::exhaustions() const
+        {
+          boost::mutex::scoped_lock lock(this->_impl->lock);
+          return this->_impl->exhaustions;
+        }
+      }
+    }
+  }
+}
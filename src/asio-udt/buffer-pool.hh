@@ -0,0 +1,103 @@
+#ifndef ASIO_UDT_BUFFER_POOL_HH
+# define ASIO_UDT_BUFFER_POOL_HH
+
+# include <cstdint>
+# include <vector>
+
+# include <boost/asio/buffer.hpp>
+# include <boost/thread/mutex.hpp>
+
+# include <asio-udt/fwd.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Fixed set of equally sized slabs shared by all reads of a
+        /// service.
+        ///
+        /// Slabs are carved out of a single allocation, made on the first
+        /// acquisition, and handed out most recently released first, so the
+        /// ones in use stay hot in cache.
+        class buffer_pool
+        {
+          private:
+            struct impl;
+
+          public:
+            /// Reference-counted handle on a slab. The slab returns to the
+            /// pool when the last copy is destroyed or released, even if the
+            /// pool is gone by then. Counts are kept by the pool: acquiring
+            /// a slab does not allocate.
+            class slab
+            {
+              public:
+                /// An empty handle.
+                slab();
+                slab(slab const& source);
+                slab(slab&& source);
+                ~slab();
+                slab&
+                operator =(slab source);
+                explicit
+                operator bool() const;
+                char*
+                data() const;
+                /// Number of bytes received in the slab.
+                std::size_t
+                size() const;
+                std::size_t
+                capacity() const;
+                /// The received bytes.
+                const_buffer
+                buffer() const;
+                void
+                release();
+
+              private:
+                friend class buffer_pool;
+                friend class socket;
+                slab(impl* pool, std::size_t index);
+                impl* _pool;
+                std::size_t _index;
+                std::size_t _size;
+                std::size_t _capacity;
+            };
+
+          public:
+            buffer_pool(std::size_t slab_size = 65536,
+                        std::size_t count = 256);
+            buffer_pool(buffer_pool const& source);
+            ~buffer_pool();
+            buffer_pool&
+            operator =(buffer_pool source);
+
+          public:
+            /// A free slab, or an empty handle if all are in use.
+            slab
+            acquire();
+            std::size_t
+            slab_size() const;
+            std::size_t
+            count() const;
+            /// Number of slabs currently handed out.
+            std::size_t
+            in_use() const;
+            /// Number of acquisitions that failed because all slabs were in
+            /// use.
+            std::uint64_t
+            exhaustions() const;
+
+          private:
+            impl* _impl;
+        };
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include <cstring>
+
+#include <asio-udt/checksum.hh>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+# define ASIO_UDT_CRC32C_SSE42
+# include <nmmintrin.h>
+#endif
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Reflected Castagnoli polynomial.
+        static std::uint32_t const polynomial = 0x82f63b78;
+
+        namespace
+        {
+          struct Tables
+          {
+            Tables()
+            {
+              for (std::uint32_t i = 0; i < 256; ++i)
+              {
+                std::uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit)
+                  crc = (crc >> 1) ^ (polynomial & (0 - (crc & 1)));
+                this->table[0][i] = crc;
+              }
+              for (std::uint32_t i = 0; i < 256; ++i)
+                for (int t = 1; t < 8; ++t)
+                  this->table[t][i] =
+                    (this->table[t - 1][i] >> 8) ^
+                    this->table[0][this->table[t - 1][i] & 0xff];
+            }
+
+            std::uint32_t table[8][256];
+          };
+        }
+
+        static
+        std::uint32_t
+        crc32c_software(unsigned char const* p, std::size_t size,
+                        std::uint32_t crc)
+        {
+          static Tables const tables;
+          auto const& t = tables.table;
+          // Slicing-by-8 assumes a little endian load.
+          for (; size >= 8; size -= 8, p += 8)
+          {
+            std::uint32_t low = (p[0] | p[1] << 8 | p[2] << 16 |
+                                 std::uint32_t(p[3]) << 24) ^ crc;
+            std::uint32_t high = p[4] | p[5] << 8 | p[6] << 16 |
+              std::uint32_t(p[7]) << 24;
+            crc =
+              t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^
+              t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+              t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^
+              t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+          }
+          for (; size > 0; --size, ++p)
+            crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+          return crc;
+        }
+
+#ifdef ASIO_UDT_CRC32C_SSE42
+        __attribute__((target("sse4.2")))
+        static
+        std::uint32_t
+        crc32c_sse42(unsigned char const* p, std::size_t size,
+                     std::uint32_t crc)
+        {
+          for (; size > 0 && reinterpret_cast<std::uintptr_t>(p) % 8;
+               --size, ++p)
+            crc = _mm_crc32_u8(crc, *p);
+# ifdef __x86_64__
+          std::uint64_t crc64 = crc;
+          for (; size >= 8; size -= 8, p += 8)
+          {
+            std::uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            crc64 = _mm_crc32_u64(crc64, word);
+          }
+          crc = static_cast<std::uint32_t>(crc64);
+# endif
+          for (; size >= 4; size -= 4, p += 4)
+          {
+            std::uint32_t word;
+            std::memcpy(&word, p, sizeof(word));
+            crc = _mm_crc32_u32(crc, word);
+          }
+          for (; size > 0; --size, ++p)
+            crc = _mm_crc32_u8(crc, *p);
+          return crc;
+        }
+#endif
+
+        bool
+        crc32c_accelerated()
+        {
+#ifdef ASIO_UDT_CRC32C_SSE42
+          static bool const res = __builtin_cpu_supports("sse4.2");
+          return res;
+#else
+          return false;
+#endif
+        }
+
+        std::uint32_t
+        crc32c(void const* data, std::size_t size, std::uint32_t crc)
+        {
+          auto p = static_cast<unsigned char const*>(data);
+          crc = ~crc;
+#ifdef ASIO_UDT_CRC32C_SSE42
+          if (crc32c_accelerated())
+            return ~crc32c_sse42(p, size, crc);
+#endif
+          return ~crc32c_software(p, size, crc);
+        }
+
+        std::uint32_t
+        crc32c_portable(void const* data, std::size_t size, std::uint32_t crc)
+        {
+          return ~crc32c_software(static_cast<unsigned char const*>(data),
+                                  size, ~crc);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,34 @@
+#ifndef ASIO_UDT_CHECKSUM_HH
+# define ASIO_UDT_CHECKSUM_HH
+
+# include <cstddef>
+# include <cstdint>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// CRC-32C (Castagnoli) of size bytes at data, continuing crc so
+        /// blocks can be checksummed in sequence. Uses the SSE4.2 crc32
+        /// instruction when the CPU has it, slicing-by-8 tables otherwise.
+        std::uint32_t
+        crc32c(void const* data, std::size_t size, std::uint32_t crc = 0);
+
+        /// crc32c without hardware acceleration, whatever the CPU.
+        std::uint32_t
+        crc32c_portable(void const* data, std::size_t size,
+                        std::uint32_t crc = 0);
+
+        /// Whether crc32c is hardware accelerated.
+        bool
+        crc32c_accelerated();
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cstring>
+
+#include <lz4.h>
+
+#include <asio-udt/compressed-stream.hh>
+
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("boost.asio.ip.udt.compressed_stream");
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Frame header: big endian 32-bit payload size, whose top bit
+        /// flags compressed payloads, and 32-bit raw size.
+        static std::size_t const header_size = 8;
+        static std::uint32_t const compressed_flag = 0x80000000;
+        /// Reject bogus headers rather than allocating them.
+        static std::uint32_t const max_frame_size = 1 << 24;
+        /// Compress while sampled frames shrink below this ratio.
+        static double const max_ratio = 0.9;
+        /// Frames sent raw between two samples, once switched off.
+        static unsigned const sample_interval = 64;
+
+        static
+        void
+        encode(char* data, std::uint32_t value)
+        {
+          for (int i = 0; i < 4; ++i)
+            data[i] = (value >> (24 - 8 * i)) & 0xff;
+        }
+
+        static
+        std::uint32_t
+        decode(char const* data)
+        {
+          std::uint32_t res = 0;
+          for (int i = 0; i < 4; ++i)
+            res = (res << 8) | static_cast<unsigned char>(data[i]);
+          return res;
+        }
+
+        static
+        system::error_code
+        bad_frame()
+        {
+          return system::errc::make_error_code(system::errc::bad_message);
+        }
+
+        compressed_stream::compressed_stream(socket& sock,
+                                             io_service& workers,
+                                             std::size_t frame_size)
+          : _socket(sock)
+          , _workers(workers)
+          , _frame(std::min<std::size_t>(frame_size, max_frame_size))
+          , _compressing(true)
+          , _ratio(0)
+          , _unsampled(0)
+          , _raw_bytes(0)
+          , _wire_bytes(0)
+          , _decoded_offset(0)
+        {}
+
+        io_service&
+        compressed_stream::get_io_service()
+        {
+          return this->_socket.get_io_service();
+        }
+
+        bool
+        compressed_stream::compressing() const
+        {
+          return this->_compressing;
+        }
+
+        double
+        compressed_stream::ratio() const
+        {
+          return this->_ratio;
+        }
+
+        std::uint64_t
+        compressed_stream::raw_bytes() const
+        {
+          return this->_raw_bytes;
+        }
+
+        std::uint64_t
+        compressed_stream::wire_bytes() const
+        {
+          return this->_wire_bytes;
+        }
+
+        void
+        compressed_stream::_write_some(const_buffer buffer, Done done)
+        {
+          auto data = buffer_cast<char const*>(buffer);
+          auto size = std::min(buffer_size(buffer), this->_frame);
+          if (size == 0)
+            return done(system::error_code(), 0);
+          if (!this->_compressing && ++this->_unsampled < sample_interval)
+          {
+            this->_output.resize(header_size + size);
+            std::memcpy(this->_output.data() + header_size, data, size);
+            return this->_send(size, size, false, std::move(done));
+          }
+          this->_unsampled = 0;
+          auto& service = this->get_io_service();
+          asio::post(
+            this->_workers,
+            [this, data, size, done, &service] ()
+            {
+              int bound = LZ4_compressBound(size);
+              this->_output.resize(header_size + bound);
+              int compressed = LZ4_compress_default(
+                data, this->_output.data() + header_size, size, bound);
+              asio::post(
+                service,
+                [this, data, size, compressed, done] ()
+                {
+                  this->_sample(size, compressed > 0 ? compressed : size);
+                  if (compressed > 0 && std::size_t(compressed) < size)
+                    return this->_send(size, compressed, true, done);
+                  this->_output.resize(header_size + size);
+                  std::memcpy(this->_output.data() + header_size, data, size);
+                  this->_send(size, size, false, done);
+                });
+            });
+        }
+
+        void
+        compressed_stream::_sample(std::size_t raw, std::size_t compressed)
+        {
+          double ratio = double(compressed) / raw;
+          this->_ratio = this->_ratio == 0 ?
+            ratio : this->_ratio * 7 / 8 + ratio / 8;
+          bool compressing = this->_ratio < max_ratio;
+          if (compressing != this->_compressing)
+            ELLE_TRACE("%s compression, ratio %s",
+                       compressing ? "resume" : "suspend", this->_ratio);
+          this->_compressing = compressing;
+        }
+
+        void
+        compressed_stream::_send(std::size_t raw, std::size_t payload,
+                                 bool compressed, Done done)
+        {
+          encode(this->_output.data(),
+                 payload | (compressed ? compressed_flag : 0));
+          encode(this->_output.data() + 4, raw);
+          this->_write(
+            boost::asio::buffer(this->_output.data(), header_size + payload),
+            [this, raw, payload, done] (system::error_code const& error)
+            {
+              if (error)
+                return done(error, 0);
+              this->_raw_bytes += raw;
+              this->_wire_bytes += header_size + payload;
+              done(error, raw);
+            });
+        }
+
+        void
+        compressed_stream::_read_some(mutable_buffer buffer, Done done)
+        {
+          if (this->_decoded_offset < this->_decoded.size())
+            return this->_deliver(buffer, std::move(done));
+          this->_read(
+            boost::asio::buffer(this->_header, header_size),
+            [this, buffer, done] (system::error_code const& error)
+            {
+              if (error)
+                return done(error, 0);
+              auto stored = decode(this->_header);
+              bool compressed = stored & compressed_flag;
+              std::size_t payload = stored & ~compressed_flag;
+              std::size_t raw = decode(this->_header + 4);
+              if (raw > max_frame_size ||
+                  payload > std::size_t(LZ4_compressBound(max_frame_size)) ||
+                  (!compressed && payload != raw))
+                return done(bad_frame(), 0);
+              this->_input.resize(payload);
+              this->_read(
+                boost::asio::buffer(this->_input.data(), payload),
+                [this, buffer, done, compressed, payload, raw]
+                (system::error_code const& error)
+                {
+                  if (error)
+                    return done(error, 0);
+                  this->_decoded_offset = 0;
+                  if (!compressed)
+                  {
+                    this->_decoded.swap(this->_input);
+                    return this->_deliver(buffer, done);
+                  }
+                  auto& service = this->get_io_service();
+                  asio::post(
+                    this->_workers,
+                    [this, buffer, done, payload, raw, &service] ()
+                    {
+                      this->_decoded.resize(raw);
+                      int size = LZ4_decompress_safe(
+                        this->_input.data(), this->_decoded.data(),
+                        payload, raw);
+                      asio::post(
+                        service,
+                        [this, buffer, done, size, raw] ()
+                        {
+                          if (size < 0 || std::size_t(size) != raw)
+                          {
+                            this->_decoded.clear();
+                            return done(bad_frame(), 0);
+                          }
+                          this->_deliver(buffer, done);
+                        });
+                    });
+                });
+            });
+        }
+
+        void
+        compressed_stream::_deliver(mutable_buffer buffer, Done done)
+        {
+          auto size = std::min(buffer_size(buffer),
+                               this->_decoded.size() - this->_decoded_offset);
+          std::memcpy(buffer_cast<char*>(buffer),
+                      this->_decoded.data() + this->_decoded_offset, size);
+          this->_decoded_offset += size;
+          done(system::error_code(), size);
+        }
+
+        void
+        compressed_stream::_write(const_buffer buffer, Step step)
+        {
+          this->_socket.async_write_some(
+            buffer,
+            [this, buffer, step] (system::error_code const& error,
+                                  std::size_t size)
+            {
+              if (!error && size < buffer_size(buffer))
+                return this->_write(buffer + size, step);
+              step(error);
+            });
+        }
+
+        void
+        compressed_stream::_read(mutable_buffer buffer, Step step)
+        {
+          this->_socket.async_read_some(
+            buffer,
+            [this, buffer, step] (system::error_code const& error,
+                                  std::size_t size)
+            {
+              if (!error && size < buffer_size(buffer))
+                return this->_read(buffer + size, step);
+              step(error);
+            });
+        }
+      }
+    }
+  }
+}
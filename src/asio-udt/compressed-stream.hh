@@ -0,0 +1,115 @@
+#ifndef ASIO_UDT_COMPRESSED_STREAM_HH
+# define ASIO_UDT_COMPRESSED_STREAM_HH
+
+# include <cstdint>
+# include <functional>
+# include <utility>
+# include <vector>
+
+# include <boost/asio.hpp>
+# include <boost/noncopyable.hpp>
+
+# include <asio-udt/fwd.hh>
+# include <asio-udt/socket.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// LZ4 compression over a connected socket, with the socket
+        /// asynchronous read and write interface.
+        ///
+        /// Data is sent in frames of at most frame_size bytes, compressed
+        /// on the workers io_service so the threads running the socket do
+        /// not stall. The compression ratio is sampled: when frames stop
+        /// shrinking enough, they are sent raw and only one in a while is
+        /// compressed again to detect compressible data. Both ends must
+        /// use a compressed_stream.
+        class compressed_stream: public boost::noncopyable
+        {
+          public:
+            /// Wrap sock, which must outlive the stream. Workers are
+            /// typically run by a thread pool.
+            compressed_stream(socket& sock, io_service& workers,
+                              std::size_t frame_size = 65536);
+
+          public:
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::size_t))
+            async_read_some(mutable_buffer buffer, Handler&& handler);
+            /// Write at most one frame of buffer.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::size_t))
+            async_write_some(const_buffer buffer, Handler&& handler);
+            io_service&
+            get_io_service();
+            /// Whether frames are currently compressed.
+            bool
+            compressing() const;
+            /// Average compressed to raw size ratio of sampled frames.
+            double
+            ratio() const;
+            /// Bytes written by the application, respectively sent over
+            /// the socket.
+            std::uint64_t
+            raw_bytes() const;
+            std::uint64_t
+            wire_bytes() const;
+
+          private:
+            typedef std::function<void (system::error_code const&,
+                                        std::size_t)> Done;
+            typedef std::function<void (system::error_code const&)> Step;
+            struct _initiate_read_some;
+            struct _initiate_write_some;
+            void
+            _read_some(mutable_buffer buffer, Done done);
+            void
+            _write_some(const_buffer buffer, Done done);
+            /// Send the frame in _output, of compressed or raw payload.
+            void
+            _send(std::size_t raw, std::size_t payload, bool compressed,
+                  Done done);
+            /// Update the ratio with a sampled frame.
+            void
+            _sample(std::size_t raw, std::size_t compressed);
+            /// Copy decoded data to buffer.
+            void
+            _deliver(mutable_buffer buffer, Done done);
+            /// Transfer buffer entirely, looping on partial operations.
+            void
+            _write(const_buffer buffer, Step step);
+            void
+            _read(mutable_buffer buffer, Step step);
+
+            socket& _socket;
+            io_service& _workers;
+            std::size_t _frame;
+            std::vector<char> _output;
+            bool _compressing;
+            double _ratio;
+            /// Raw frames sent since the last sample.
+            unsigned _unsampled;
+            std::uint64_t _raw_bytes;
+            std::uint64_t _wire_bytes;
+            char _header[8];
+            std::vector<char> _input;
+            std::vector<char> _decoded;
+            std::size_t _decoded_offset;
+        };
+      }
+    }
+  }
+}
+
+# include <asio-udt/compressed-stream.hxx>
+
+#endif
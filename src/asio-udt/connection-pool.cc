@@ -0,0 +1,187 @@
+#include <asio-udt/connection-pool.hh>
+
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("boost.asio.ip.udt.connection_pool");
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        connection_pool::connection_pool(
+          io_service& io_service,
+          std::size_t max_idle,
+          posix_time::time_duration const& max_age)
+          : _service(io_service)
+          , _max_idle(max_idle)
+          , _max_age(max_age)
+          , _reaper(io_service)
+          , _reaping(false)
+          , _anchor(std::make_shared<connection_pool*>(this))
+        {}
+
+        connection_pool::~connection_pool()
+        {
+          *this->_anchor = nullptr;
+          this->clear();
+        }
+
+        socket*
+        connection_pool::_take(endpoint_type const& peer)
+        {
+          boost::mutex::scoped_lock lock(this->_lock);
+          auto it = this->_idle.find(peer);
+          if (it == this->_idle.end())
+            return nullptr;
+          auto& idle = it->second;
+          this->_expire(idle, posix_time::microsec_clock::universal_time());
+          std::unique_ptr<socket> res;
+          // Most recently released first: least likely to have timed out.
+          while (!res && !idle.empty())
+          {
+            auto sock = std::move(idle.back().sock);
+            idle.pop_back();
+            if (_alive(*sock))
+              res = std::move(sock);
+            else
+            {
+              ELLE_DEBUG("%s: drop dead connection to %s", *this, peer);
+              _close(std::move(sock));
+            }
+          }
+          if (idle.empty())
+            this->_idle.erase(it);
+          if (this->_idle.empty())
+            this->_reaper.cancel();
+          if (res)
+            ELLE_TRACE("%s: reuse connection to %s", *this, peer);
+          return res.release();
+        }
+
+        void
+        connection_pool::release(socket* released)
+        {
+          std::unique_ptr<socket> sock(released);
+          auto peer = sock->remote_endpoint();
+          if (!_alive(*sock))
+          {
+            ELLE_DEBUG("%s: close released dead connection to %s",
+                       *this, peer);
+            return _close(std::move(sock));
+          }
+          if (this->_max_idle == 0)
+            return _close(std::move(sock));
+          auto now = posix_time::microsec_clock::universal_time();
+          boost::mutex::scoped_lock lock(this->_lock);
+          auto& idle = this->_idle[peer];
+          this->_expire(idle, now);
+          // Evict the oldest connection rather than refusing the freshest.
+          if (idle.size() >= this->_max_idle)
+          {
+            _close(std::move(idle.front().sock));
+            idle.pop_front();
+          }
+          ELLE_TRACE("%s: keep connection to %s", *this, peer);
+          idle.push_back(Idle{std::move(sock), now});
+          this->_arm();
+        }
+
+        void
+        connection_pool::_expire(std::deque<Idle>& idle, posix_time::ptime now)
+        {
+          while (!idle.empty() && now - idle.front().since >= this->_max_age)
+          {
+            ELLE_DEBUG("%s: close connection idle since %s",
+                       *this, idle.front().since);
+            _close(std::move(idle.front().sock));
+            idle.pop_front();
+          }
+        }
+
+        void
+        connection_pool::_arm()
+        {
+          if (this->_reaping || this->_idle.empty())
+            return;
+          auto oldest = posix_time::ptime(posix_time::pos_infin);
+          for (auto const& peer: this->_idle)
+            oldest = std::min(oldest, peer.second.front().since);
+          this->_reaping = true;
+          this->_reaper.expires_at(oldest + this->_max_age);
+          std::weak_ptr<connection_pool*> anchor = this->_anchor;
+          this->_reaper.async_wait(
+            [anchor] (system::error_code const&)
+            {
+              auto self = anchor.lock();
+              if (self && *self)
+                (*self)->_reap();
+            });
+        }
+
+        void
+        connection_pool::_reap()
+        {
+          boost::mutex::scoped_lock lock(this->_lock);
+          this->_reaping = false;
+          auto now = posix_time::microsec_clock::universal_time();
+          for (auto it = this->_idle.begin(); it != this->_idle.end();)
+          {
+            this->_expire(it->second, now);
+            if (it->second.empty())
+              it = this->_idle.erase(it);
+            else
+              ++it;
+          }
+          this->_arm();
+        }
+
+        bool
+        connection_pool::_alive(socket& sock)
+        {
+          if (UDT::getsockstate(sock._udt_socket) != CONNECTED)
+            return false;
+          // Leftovers would be mistaken for the next exchange.
+          int pending = 0;
+          int size = sizeof(pending);
+          return UDT::getsockopt(sock._udt_socket, 0, UDT_RCVDATA,
+                                 &pending, &size) != UDT::ERROR &&
+            pending == 0;
+        }
+
+        void
+        connection_pool::_close(std::unique_ptr<socket> sock)
+        {
+          sock->async_close();
+        }
+
+        std::size_t
+        connection_pool::idle() const
+        {
+          boost::mutex::scoped_lock lock(this->_lock);
+          std::size_t res = 0;
+          for (auto const& peer: this->_idle)
+            res += peer.second.size();
+          return res;
+        }
+
+        void
+        connection_pool::clear()
+        {
+          Map idle;
+          {
+            boost::mutex::scoped_lock lock(this->_lock);
+            std::swap(idle, this->_idle);
+            this->_reaper.cancel();
+          }
+          for (auto& peer: idle)
+            for (auto& connection: peer.second)
+              _close(std::move(connection.sock));
+        }
+      }
+    }
+  }
+}
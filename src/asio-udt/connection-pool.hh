@@ -0,0 +1,111 @@
+#ifndef ASIO_UDT_CONNECTION_POOL_HH
+# define ASIO_UDT_CONNECTION_POOL_HH
+
+# include <deque>
+# include <map>
+# include <memory>
+# include <utility>
+
+# include <boost/asio.hpp>
+# include <boost/noncopyable.hpp>
+# include <boost/thread/mutex.hpp>
+
+# include <asio-udt/fwd.hh>
+# include <asio-udt/socket.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Established connections kept warm for reuse, per peer.
+        ///
+        /// Sockets are handed out for exclusive use and given back with
+        /// release once idle, saving the handshake round trip and buffer
+        /// allocation of the next connection to the same peer.
+        class connection_pool: public boost::noncopyable
+        {
+          public:
+            typedef socket::endpoint_type endpoint_type;
+
+          public:
+            /// Keep at most max_idle connections per peer, for at most
+            /// max_age since their release. Connections are reaped by a
+            /// timer, which keeps io_service busy while any is idle.
+            connection_pool(io_service& io_service,
+                            std::size_t max_idle = 8,
+                            posix_time::time_duration const& max_age =
+                              posix_time::seconds(60));
+            ~connection_pool();
+
+          public:
+            /// A connection to peer: a live idle one if any, a new one
+            /// otherwise. The handler owns the socket.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code, socket*))
+            async_get(endpoint_type const& peer, Handler&& handler);
+            /// Give back a connection obtained from async_get, with no
+            /// pending operation nor unread data. It is closed if dead,
+            /// or if the pool of its peer is full.
+            void
+            release(socket* sock);
+            /// Number of idle connections.
+            std::size_t
+            idle() const;
+            /// Close all idle connections.
+            void
+            clear();
+
+          private:
+            struct _initiate_get;
+            /// A live idle connection to peer, or null.
+            socket*
+            _take(endpoint_type const& peer);
+            /// Whether sock is connected, without unread data.
+            static
+            bool
+            _alive(socket& sock);
+            /// Close sock in the background.
+            static
+            void
+            _close(std::unique_ptr<socket> sock);
+
+            struct Idle
+            {
+              std::unique_ptr<socket> sock;
+              posix_time::ptime since;
+            };
+            typedef std::map<endpoint_type, std::deque<Idle>> Map;
+            /// Close connections of idle that are too old.
+            void
+            _expire(std::deque<Idle>& idle, posix_time::ptime now);
+            /// Wait for the oldest idle connection to expire, if not
+            /// already. Called with the lock held.
+            void
+            _arm();
+            /// Close expired connections of all peers.
+            void
+            _reap();
+
+            io_service& _service;
+            std::size_t _max_idle;
+            posix_time::time_duration _max_age;
+            Map _idle;
+            deadline_timer _reaper;
+            bool _reaping;
+            mutable boost::mutex _lock;
+            /// This pool, for reaper completions that outlive it.
+            std::shared_ptr<connection_pool*> _anchor;
+        };
+      }
+    }
+  }
+}
+
+# include <asio-udt/connection-pool.hxx>
+
+#endif
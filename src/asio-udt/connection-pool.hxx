@@ -0,0 +1,77 @@
+#ifndef ASIO_UDT_CONNECTION_POOL_HXX
+# define ASIO_UDT_CONNECTION_POOL_HXX
+
+# include <memory>
+
+# include <boost/asio/async_result.hpp>
+# include <boost/asio/detail/bind_handler.hpp>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        struct connection_pool::_initiate_get
+        {
+          connection_pool* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler, endpoint_type const& peer) const
+          {
+            auto& service = this->self->_service;
+            if (auto sock = this->self->_take(peer))
+            {
+              asio::post(service,
+                         asio::detail::bind_handler(
+                           std::forward<Handler>(handler),
+                           system::error_code(), sock));
+              return;
+            }
+            typedef typename std::decay<Handler>::type Completion;
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            // Complete through post, so the handler runs on its associated
+            // executor.
+            auto complete = [h, &service] (system::error_code const& error,
+                                           socket* sock)
+              {
+                asio::post(service,
+                           asio::detail::bind_handler(std::move(*h),
+                                                      error, sock));
+              };
+            auto sock =
+              std::make_shared<std::unique_ptr<socket>>(new socket(service));
+            (*sock)->async_connect(
+              peer,
+              [sock, complete] (system::error_code const& error)
+              {
+                if (error)
+                {
+                  sock->reset();
+                  complete(error, nullptr);
+                }
+                else
+                  complete(error, sock->release());
+              });
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, socket*))
+        connection_pool::async_get(endpoint_type const& peer,
+                                   Handler&& handler)
+        {
+          return async_initiate<Handler, void (system::error_code, socket*)>(
+            _initiate_get{this}, handler, peer);
+        }
+      }
+    }
+  }
+}
+
+#endif
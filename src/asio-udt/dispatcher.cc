@@ -0,0 +1,243 @@
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <asio-udt/dispatcher.hh>
+#include <asio-udt/error-category.hh>
+#include <asio-udt/service.hh>
+#include <asio-udt/statistics.hh>
+
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("boost.asio.ip.udt.dispatcher");
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        dispatcher&
+        dispatcher::instance()
+        {
+          static dispatcher res;
+          return res;
+        }
+
+        /// Delay, in milliseconds, before waiting again after a failed
+        /// wait.
+        static const int failure_delay = 10;
+
+        namespace
+        {
+          /// Events of a wakeup routed to one service.
+          struct Events
+          {
+            std::set<int> read;
+            std::set<int> write;
+            std::set<int> system_read;
+            std::set<int> system_write;
+          };
+        }
+
+        dispatcher::dispatcher()
+          : _epoll(UDT::epoll_create())
+          , _stop(false)
+          , _running(false)
+        {
+          if (::pipe(this->_interrupt) == -1)
+            throw_errno();
+          ::fcntl(this->_interrupt[0], F_SETFL, O_NONBLOCK);
+          ::fcntl(this->_interrupt[1], F_SETFL, O_NONBLOCK);
+          int flags = UDT_EPOLL_IN;
+          UDT::epoll_add_ssock(this->_epoll, this->_interrupt[0], &flags);
+        }
+
+        dispatcher::~dispatcher()
+        {
+          {
+            boost::unique_lock<boost::mutex> lock(this->_lock);
+            this->_stop = true;
+          }
+          this->wakeup();
+          if (this->_thread)
+            this->_thread->join();
+          UDT::epoll_release(this->_epoll);
+          ::close(this->_interrupt[0]);
+          ::close(this->_interrupt[1]);
+        }
+
+        int
+        dispatcher::epoll() const
+        {
+          return this->_epoll;
+        }
+
+        void
+        dispatcher::add(service* service)
+        {
+          boost::unique_lock<boost::mutex> lock(this->_lock);
+          ELLE_TRACE("%s: add %s", *this, *service);
+          this->_services.insert(service);
+        }
+
+        void
+        dispatcher::remove(service* service)
+        {
+          // Waits for the reactor to be done with the service.
+          boost::unique_lock<boost::mutex> lock(this->_lock);
+          ELLE_TRACE("%s: remove %s", *this, *service);
+          this->_services.erase(service);
+          boost::unique_lock<boost::mutex> routes(this->_routes_lock);
+          for (auto routes: {&this->_routes, &this->_system_routes})
+            for (auto it = routes->begin(); it != routes->end();)
+              if (it->second == service)
+                it = routes->erase(it);
+              else
+                ++it;
+        }
+
+        void
+        dispatcher::route(int fd, bool system, service* owner)
+        {
+          boost::unique_lock<boost::mutex> lock(this->_routes_lock);
+          auto& routes = system ? this->_system_routes : this->_routes;
+          if (owner)
+            routes[fd] = owner;
+          else
+            routes.erase(fd);
+        }
+
+        void
+        dispatcher::start()
+        {
+          // Not under the lock: services start the reactor with their own
+          // lock held, which the reactor takes under the dispatcher lock.
+          std::call_once(this->_started, [this] ()
+          {
+            ELLE_TRACE("%s: start reactor", *this);
+            this->_thread.reset(
+              new boost::thread(std::bind(&dispatcher::_run, this)));
+            this->_running = true;
+          });
+        }
+
+        bool
+        dispatcher::running() const
+        {
+          return this->_running;
+        }
+
+        void
+        dispatcher::wakeup()
+        {
+          char c = 0;
+          // A full pipe already guarantees a wakeup.
+          if (::write(this->_interrupt[1], &c, 1) == -1)
+            ELLE_DUMP("%s: wakeup already pending", *this);
+        }
+
+        void
+        dispatcher::_run()
+        {
+          std::set<int> const none;
+          while (true)
+          {
+            int timeout = -1;
+            {
+              boost::unique_lock<boost::mutex> lock(this->_lock);
+              if (this->_stop)
+                return;
+              for (auto service: this->_services)
+              {
+                boost::unique_lock<boost::mutex> lock(service->_lock);
+                int t = service->_timeout();
+                if (t >= 0 && (timeout < 0 || t < timeout))
+                  timeout = t;
+              }
+            }
+            std::set<UDTSOCKET> readfds;
+            std::set<UDTSOCKET> writefds;
+            std::set<SYSSOCKET> sysfds;
+            std::set<SYSSOCKET> syswritefds;
+            // The self-pipe is always monitored, ruling out EINVPARAM.
+            if (UDT::epoll_wait(this->_epoll, &readfds, &writefds,
+                                timeout, &sysfds, &syswritefds) < 0 &&
+                UDT::getlasterror().getErrorCode() != udt_category::ETIMEOUT)
+            {
+              // Throwing would terminate the process: fail the pending
+              // operations instead, and retry later on.
+              auto error = udt_error();
+              ELLE_WARN("%s: wait error: %s", *this, error.message());
+              {
+                boost::unique_lock<boost::mutex> lock(this->_lock);
+                if (this->_stop)
+                  return;
+                for (auto service: this->_services)
+                  service->_fail(error);
+              }
+              boost::this_thread::sleep_for(
+                boost::chrono::milliseconds(failure_delay));
+              continue;
+            }
+            if (sysfds.find(this->_interrupt[0]) != sysfds.end())
+            {
+              char buffer[64];
+              while (::read(this->_interrupt[0], buffer, sizeof(buffer)) > 0)
+                ;
+            }
+            auto now = timing_wheel::Clock::now();
+            instrument::wakeup(readfds.size() + writefds.size() +
+                               sysfds.size() + syswritefds.size());
+            boost::unique_lock<boost::mutex> lock(this->_lock);
+            if (this->_stop)
+              return;
+            std::unordered_map<service*, Events> events;
+            {
+              boost::unique_lock<boost::mutex> lock(this->_routes_lock);
+              typedef std::unordered_map<int, service*> Routes;
+              auto route = [&] (std::set<int> const& fds,
+                                Routes const& routes,
+                                std::set<int> Events::* set)
+                {
+                  for (auto fd: fds)
+                  {
+                    auto it = routes.find(fd);
+                    if (it != routes.end())
+                      (events[it->second].*set).insert(fd);
+                  }
+                };
+              route(readfds, this->_routes, &Events::read);
+              route(writefds, this->_routes, &Events::write);
+              route(sysfds, this->_system_routes, &Events::system_read);
+              route(syswritefds, this->_system_routes, &Events::system_write);
+            }
+            for (auto service: this->_services)
+            {
+              auto it = events.find(service);
+              if (it != events.end())
+              {
+                auto const& e = it->second;
+                service->_dispatch(e.read, e.write, e.system_read,
+                                   e.system_write, now);
+                continue;
+              }
+              // Expire timeouts and check drains of services without
+              // events only when due.
+              bool due;
+              {
+                boost::unique_lock<boost::mutex> lock(service->_lock);
+                due = service->_wait_deadline <= now;
+              }
+              if (due)
+                service->_dispatch(none, none, none, none, now);
+            }
+          }
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,85 @@
+#ifndef ASIO_UDT_DISPATCHER_HH
+# define ASIO_UDT_DISPATCHER_HH
+
+# include <atomic>
+# include <memory>
+# include <mutex>
+# include <set>
+# include <unordered_map>
+
+# include <boost/noncopyable.hpp>
+# include <boost/thread.hpp>
+
+# include <asio-udt/fwd.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Process-wide reactor of the services in shared mode.
+        ///
+        /// One UDT epoll and one thread, started on the first operation,
+        /// serve all shared services: each event is routed to the service
+        /// monitoring its socket or fd, which posts it to its io_service.
+        /// Services with neither events nor deadlines due are left alone.
+        class dispatcher: public boost::noncopyable
+        {
+          public:
+            static
+            dispatcher&
+            instance();
+            ~dispatcher();
+
+          public:
+            /// The shared UDT epoll.
+            int
+            epoll() const;
+            void
+            add(service* service);
+            /// Once returned, service is not used anymore.
+            void
+            remove(service* service);
+            /// Start the reactor thread, if not already.
+            void
+            start();
+            /// Whether the reactor thread was started.
+            bool
+            running() const;
+            /// Make the reactor recompute its timeout.
+            void
+            wakeup();
+            /// Route the events of UDT socket fd, or system fd if system,
+            /// to owner, or to nobody if null.
+            void
+            route(int fd, bool system, service* owner);
+
+          private:
+            dispatcher();
+            void
+            _run();
+
+            int _epoll;
+            /// Self-pipe to interrupt the epoll wait.
+            int _interrupt[2];
+            boost::mutex _lock;
+            std::set<service*> _services;
+            /// Owners of monitored UDT sockets and system fds. Taken last,
+            /// under service locks or _lock.
+            std::unordered_map<int, service*> _routes;
+            std::unordered_map<int, service*> _system_routes;
+            mutable boost::mutex _routes_lock;
+            bool _stop;
+            std::once_flag _started;
+            std::atomic<bool> _running;
+            std::unique_ptr<boost::thread> _thread;
+        };
+      }
+    }
+  }
+}
+
+#endif
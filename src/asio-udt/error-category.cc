@@ -25,9 +25,14 @@ namespace boost
         void
         throw_udt(std::string const& what)
         {
-          system::error_code ec(UDT::getlasterror().getErrorCode(),
-                                udt_category::get());
-          throw system::system_error(ec, what);
+          throw system::system_error(udt_error(), what);
+        }
+
+        system::error_code
+        udt_error()
+        {
+          return system::error_code(UDT::getlasterror().getErrorCode(),
+                                    udt_category::get());
         }
 
         udt_category&
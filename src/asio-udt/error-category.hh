@@ -18,6 +18,10 @@ namespace boost
         void
         throw_udt(std::string const& what = "");
 
+        /// Error of the last failed UDT call in this thread.
+        system::error_code
+        udt_error();
+
         class udt_category : public system::error_category
         {
           public:
@@ -0,0 +1,431 @@
+#include <algorithm>
+#include <cerrno>
+#include <memory>
+
+#include <unistd.h>
+
+#include <asio-udt/checksum.hh>
+#include <asio-udt/file-transfer.hh>
+
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("boost.asio.ip.udt.file_transfer");
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Manifest header: big endian 64-bit file size, 32-bit chunk size
+        /// and 32-bit chunk count, followed by the 32-bit checksum of each
+        /// chunk. The receiver answers with the 32-bit index of the first
+        /// chunk it needs.
+        static std::size_t const header_size = 16;
+        /// Reject bogus manifests rather than allocating them: checksums of
+        /// at most 64MiB, chunks of at most 64MiB.
+        static std::uint32_t const max_chunk_size = 1 << 26;
+        static std::uint64_t const max_chunk_count = 1 << 24;
+
+        static
+        void
+        encode(char* data, std::uint64_t value, int bytes)
+        {
+          for (int i = 0; i < bytes; ++i)
+            data[i] = (value >> (8 * (bytes - 1 - i))) & 0xff;
+        }
+
+        static
+        std::uint64_t
+        decode(char const* data, int bytes)
+        {
+          std::uint64_t res = 0;
+          for (int i = 0; i < bytes; ++i)
+            res = (res << 8) | static_cast<unsigned char>(data[i]);
+          return res;
+        }
+
+        /// Number of chunks of size bytes, without overflowing.
+        static
+        std::uint64_t
+        chunk_count(std::uint64_t size, std::uint64_t chunk)
+        {
+          return size / chunk + (size % chunk != 0);
+        }
+
+        static
+        system::error_code
+        file_error()
+        {
+          return system::error_code(errno ? errno : EIO,
+                                    system::system_category());
+        }
+
+        static
+        system::error_code
+        bad_manifest()
+        {
+          return system::errc::make_error_code(system::errc::bad_message);
+        }
+
+        file_transfer::file_transfer(socket& sock, io_service& workers,
+                                     std::string path, std::size_t chunk_size)
+          : _socket(sock)
+          , _workers(workers)
+          , _path(std::move(path))
+          , _chunk(chunk_size)
+          , _size(0)
+          , _skipped(0)
+          , _transferred(0)
+        {}
+
+        std::uint64_t
+        file_transfer::skipped() const
+        {
+          return this->_skipped;
+        }
+
+        std::string const&
+        file_transfer::path() const
+        {
+          return this->_path;
+        }
+
+        std::size_t
+        file_transfer::_chunk_size(std::uint32_t index) const
+        {
+          auto start = std::uint64_t(index) * this->_chunk;
+          return std::min<std::uint64_t>(this->_chunk, this->_size - start);
+        }
+
+        void
+        file_transfer::_offload(std::function<system::error_code ()> work,
+                                Step step)
+        {
+          auto& service = this->_socket.get_io_service();
+          asio::post(
+            this->_workers,
+            [work, step, &service] ()
+            {
+              auto error = work();
+              asio::post(service, [step, error] () { step(error); });
+            });
+        }
+
+        void
+        file_transfer::_send(Done done)
+        {
+          ELLE_TRACE_SCOPE("send %s", this->_path);
+          this->_done = std::move(done);
+          this->_skipped = this->_transferred = 0;
+          // The manifest encodes the chunk size on 32 bits, and receivers
+          // reject larger chunks anyway.
+          if (this->_chunk == 0 || this->_chunk > max_chunk_size)
+            return this->_finish(
+              system::errc::make_error_code(system::errc::invalid_argument));
+          this->_offload(
+            [this]
+            {
+              errno = 0;
+              this->_file.open(this->_path, std::ios::in | std::ios::binary);
+              if (!this->_file)
+                return file_error();
+              this->_file.seekg(0, std::ios::end);
+              this->_size = this->_file.tellg();
+              if (chunk_count(this->_size, this->_chunk) > max_chunk_count)
+                return system::errc::make_error_code(
+                  system::errc::file_too_large);
+              this->_manifest();
+              if (!this->_file)
+                return file_error();
+              return system::error_code();
+            },
+            [this] (system::error_code const& error)
+            {
+              if (error)
+                return this->_finish(error);
+              this->_send_manifest();
+            });
+        }
+
+        void
+        file_transfer::_send_manifest()
+        {
+          auto count = this->_checksums.size();
+          this->_buffer.resize(std::max(header_size + 4 * count, this->_chunk));
+          auto data = this->_buffer.data();
+          encode(data, this->_size, 8);
+          encode(data + 8, this->_chunk, 4);
+          encode(data + 12, count, 4);
+          for (std::size_t i = 0; i < count; ++i)
+            encode(data + header_size + 4 * i, this->_checksums[i], 4);
+          this->_write(
+            boost::asio::buffer(data, header_size + 4 * count),
+            [this, count] (system::error_code const& error)
+            {
+              if (error)
+                return this->_finish(error);
+              this->_read(
+                boost::asio::buffer(this->_buffer.data(), 4),
+                [this, count] (system::error_code const& error)
+                {
+                  if (error)
+                    return this->_finish(error);
+                  auto index = decode(this->_buffer.data(), 4);
+                  if (index > count)
+                    return this->_finish(bad_manifest());
+                  this->_skipped = std::min<std::uint64_t>(
+                    index * this->_chunk, this->_size);
+                  ELLE_DEBUG("resume from chunk %s/%s", index, count);
+                  this->_send_chunk(index);
+                });
+            });
+        }
+
+        void
+        file_transfer::_manifest()
+        {
+          std::uint32_t count = chunk_count(this->_size, this->_chunk);
+          this->_checksums.resize(count);
+          this->_buffer.resize(this->_chunk);
+          this->_file.seekg(0);
+          for (std::uint32_t i = 0; i < count && this->_file; ++i)
+          {
+            auto size = this->_chunk_size(i);
+            this->_file.read(this->_buffer.data(), size);
+            this->_checksums[i] = crc32c(this->_buffer.data(), size);
+          }
+        }
+
+        void
+        file_transfer::_send_chunk(std::uint32_t index)
+        {
+          if (index == this->_checksums.size())
+            return this->_finish(system::error_code());
+          auto size = this->_chunk_size(index);
+          this->_offload(
+            [this, index, size]
+            {
+              errno = 0;
+              this->_file.seekg(std::uint64_t(index) * this->_chunk);
+              if (!this->_file.read(this->_buffer.data(), size))
+                return file_error();
+              return system::error_code();
+            },
+            [this, index, size] (system::error_code const& error)
+            {
+              if (error)
+                return this->_finish(error);
+              this->_write(
+                boost::asio::buffer(this->_buffer.data(), size),
+                [this, index, size] (system::error_code const& error)
+                {
+                  if (error)
+                    return this->_finish(error);
+                  this->_transferred += size;
+                  this->_send_chunk(index + 1);
+                });
+            });
+        }
+
+        void
+        file_transfer::_receive(Done done)
+        {
+          ELLE_TRACE_SCOPE("receive %s", this->_path);
+          this->_done = std::move(done);
+          this->_skipped = this->_transferred = 0;
+          this->_buffer.resize(header_size);
+          this->_read(
+            boost::asio::buffer(this->_buffer.data(), header_size),
+            [this] (system::error_code const& error)
+            {
+              if (error)
+                return this->_finish(error);
+              auto data = this->_buffer.data();
+              this->_size = decode(data, 8);
+              this->_chunk = decode(data + 8, 4);
+              std::uint64_t count = decode(data + 12, 4);
+              if (this->_chunk == 0 || this->_chunk > max_chunk_size ||
+                  count > max_chunk_count ||
+                  count != chunk_count(this->_size, this->_chunk))
+                return this->_finish(bad_manifest());
+              this->_checksums.resize(count);
+              // Also holds the 4 bytes request, whatever the manifest.
+              this->_buffer.resize(
+                std::max<std::size_t>({4 * count, this->_chunk, 4}));
+              this->_read(
+                boost::asio::buffer(this->_buffer.data(), 4 * count),
+                [this] (system::error_code const& error)
+                {
+                  if (error)
+                    return this->_finish(error);
+                  for (std::size_t i = 0; i < this->_checksums.size(); ++i)
+                    this->_checksums[i] =
+                      decode(this->_buffer.data() + 4 * i, 4);
+                  auto index = std::make_shared<std::uint32_t>(0);
+                  this->_offload(
+                    [this, index]
+                    {
+                      errno = 0;
+                      // Create the file if needed, without truncating it.
+                      this->_file.open(this->_path,
+                                       std::ios::out | std::ios::app |
+                                       std::ios::binary);
+                      this->_file.close();
+                      this->_file.open(this->_path,
+                                       std::ios::in | std::ios::out |
+                                       std::ios::binary);
+                      if (!this->_file)
+                        return file_error();
+                      this->_file.seekg(0, std::ios::end);
+                      std::uint64_t local = this->_file.tellg();
+                      *index = this->_resume(local);
+                      return system::error_code();
+                    },
+                    [this, index] (system::error_code const& error)
+                    {
+                      if (error)
+                        return this->_finish(error);
+                      this->_request(*index);
+                    });
+                });
+            });
+        }
+
+        void
+        file_transfer::_request(std::uint32_t index)
+        {
+          this->_skipped = std::min<std::uint64_t>(
+            std::uint64_t(index) * this->_chunk, this->_size);
+          ELLE_DEBUG("resume from chunk %s/%s",
+                     index, this->_checksums.size());
+          encode(this->_buffer.data(), index, 4);
+          this->_write(
+            boost::asio::buffer(this->_buffer.data(), 4),
+            [this, index] (system::error_code const& error)
+            {
+              if (error)
+                return this->_finish(error);
+              this->_receive_chunk(index);
+            });
+        }
+
+        std::uint32_t
+        file_transfer::_resume(std::uint64_t local)
+        {
+          std::uint32_t index = 0;
+          this->_file.seekg(0);
+          for (; index < this->_checksums.size(); ++index)
+          {
+            auto size = this->_chunk_size(index);
+            if (std::uint64_t(index) * this->_chunk + size > local)
+              break;
+            if (!this->_file.read(this->_buffer.data(), size) ||
+                crc32c(this->_buffer.data(), size) != this->_checksums[index])
+              break;
+          }
+          this->_file.clear();
+          return index;
+        }
+
+        void
+        file_transfer::_receive_chunk(std::uint32_t index)
+        {
+          if (index == this->_checksums.size())
+            return this->_offload(
+              [this]
+              {
+                // Drop whatever a previous, longer file left past the end.
+                this->_file.close();
+                errno = 0;
+                if (::truncate(this->_path.c_str(), this->_size) != 0)
+                  return file_error();
+                return system::error_code();
+              },
+              [this] (system::error_code const& error)
+              {
+                this->_finish(error);
+              });
+          auto size = this->_chunk_size(index);
+          this->_read(
+            boost::asio::buffer(this->_buffer.data(), size),
+            [this, index, size] (system::error_code const& error)
+            {
+              if (error)
+                return this->_finish(error);
+              this->_offload(
+                [this, index, size]
+                {
+                  if (crc32c(this->_buffer.data(), size) !=
+                      this->_checksums[index])
+                  {
+                    ELLE_WARN("checksum mismatch on chunk %s of %s",
+                              index, this->_path);
+                    return bad_manifest();
+                  }
+                  errno = 0;
+                  this->_file.seekp(std::uint64_t(index) * this->_chunk);
+                  if (!this->_file.write(this->_buffer.data(), size))
+                    return file_error();
+                  return system::error_code();
+                },
+                [this, index, size] (system::error_code const& error)
+                {
+                  if (error)
+                    return this->_finish(error);
+                  this->_transferred += size;
+                  this->_receive_chunk(index + 1);
+                });
+            });
+        }
+
+        void
+        file_transfer::_finish(system::error_code const& error)
+        {
+          ELLE_TRACE("%s: transfer done after %s bytes: %s",
+                     this->_path, this->_transferred, error.message());
+          if (this->_file.is_open())
+            this->_file.close();
+          this->_file.clear();
+          auto done = std::move(this->_done);
+          this->_done = nullptr;
+          done(error, this->_transferred);
+        }
+
+        void
+        file_transfer::_write(const_buffer buffer, Step step)
+        {
+          if (buffer_size(buffer) == 0)
+            return step(system::error_code());
+          this->_socket.async_write_some(
+            buffer,
+            [this, buffer, step] (system::error_code const& error,
+                                  std::size_t size)
+            {
+              if (!error && size < buffer_size(buffer))
+                return this->_write(buffer + size, step);
+              step(error);
+            });
+        }
+
+        void
+        file_transfer::_read(mutable_buffer buffer, Step step)
+        {
+          if (buffer_size(buffer) == 0)
+            return step(system::error_code());
+          this->_socket.async_read_some(
+            buffer,
+            [this, buffer, step] (system::error_code const& error,
+                                  std::size_t size)
+            {
+              if (!error && size < buffer_size(buffer))
+                return this->_read(buffer + size, step);
+              step(error);
+            });
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,126 @@
+#ifndef ASIO_UDT_FILE_TRANSFER_HH
+# define ASIO_UDT_FILE_TRANSFER_HH
+
+# include <cstdint>
+# include <fstream>
+# include <functional>
+# include <string>
+# include <utility>
+# include <vector>
+
+# include <boost/asio.hpp>
+# include <boost/noncopyable.hpp>
+
+# include <asio-udt/fwd.hh>
+# include <asio-udt/socket.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// One end of a resumable file transfer over a connected socket.
+        ///
+        /// The sender announces a manifest: the file size, the chunk size
+        /// and the CRC-32C of every chunk. The receiver checks the chunks
+        /// of its local copy against it and asks for the file from the
+        /// first mismatching chunk on, so a transfer interrupted by a
+        /// connection loss resumes where it stopped. Received chunks are
+        /// verified before being written. Disk accesses and checksums run
+        /// on the workers io_service, so the threads running the socket do
+        /// not stall on large files.
+        class file_transfer: public boost::noncopyable
+        {
+          public:
+            static std::size_t const default_chunk_size = 1 << 20;
+
+          public:
+            /// Transfer path over sock, which must outlive the transfer.
+            /// The chunk size is chosen by the sender. Workers are
+            /// typically run by a thread pool.
+            file_transfer(socket& sock, io_service& workers, std::string path,
+                          std::size_t chunk_size = default_chunk_size);
+
+          public:
+            /// Send the file. Completes with the number of bytes sent.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::uint64_t))
+            async_send(Handler&& handler);
+            /// Receive the file, keeping the valid chunks of any previous
+            /// attempt. Completes with the number of bytes received.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::uint64_t))
+            async_receive(Handler&& handler);
+            /// Bytes already present on the receiver, not transferred.
+            std::uint64_t
+            skipped() const;
+            std::string const&
+            path() const;
+
+          private:
+            typedef std::function<void (system::error_code const&,
+                                        std::uint64_t)> Done;
+            typedef std::function<void (system::error_code const&)> Step;
+            struct _initiate_send;
+            struct _initiate_receive;
+            void
+            _send(Done done);
+            void
+            _receive(Done done);
+            /// Run work on the workers, then step with its result on the
+            /// socket io_service.
+            void
+            _offload(std::function<system::error_code ()> work, Step step);
+            void
+            _send_manifest();
+            /// Ask the sender for chunks from index on.
+            void
+            _request(std::uint32_t index);
+            /// Checksum every chunk of the file.
+            void
+            _manifest();
+            /// Index of the first chunk of the local file, of size local,
+            /// that does not match the manifest.
+            std::uint32_t
+            _resume(std::uint64_t local);
+            void
+            _send_chunk(std::uint32_t index);
+            void
+            _receive_chunk(std::uint32_t index);
+            std::size_t
+            _chunk_size(std::uint32_t index) const;
+            void
+            _finish(system::error_code const& error);
+            /// Transfer buffer entirely, looping on partial operations.
+            void
+            _write(const_buffer buffer, Step step);
+            void
+            _read(mutable_buffer buffer, Step step);
+
+            socket& _socket;
+            io_service& _workers;
+            std::string _path;
+            std::size_t _chunk;
+            std::fstream _file;
+            std::uint64_t _size;
+            std::vector<std::uint32_t> _checksums;
+            std::vector<char> _buffer;
+            std::uint64_t _skipped;
+            std::uint64_t _transferred;
+            Done _done;
+        };
+      }
+    }
+  }
+}
+
+# include <asio-udt/file-transfer.hxx>
+
+#endif
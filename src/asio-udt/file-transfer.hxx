@@ -0,0 +1,89 @@
+#ifndef ASIO_UDT_FILE_TRANSFER_HXX
+# define ASIO_UDT_FILE_TRANSFER_HXX
+
+# include <memory>
+
+# include <boost/asio/async_result.hpp>
+# include <boost/asio/detail/bind_handler.hpp>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        struct file_transfer::_initiate_send
+        {
+          file_transfer* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler) const
+          {
+            typedef typename std::decay<Handler>::type Completion;
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            auto& service = this->self->_socket.get_io_service();
+            this->self->_send(
+              [h, &service] (system::error_code const& error,
+                             std::uint64_t size)
+              {
+                asio::post(service,
+                           asio::detail::bind_handler(std::move(*h),
+                                                      error, size));
+              });
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code,
+                                            std::uint64_t))
+        file_transfer::async_send(Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, std::uint64_t)>(
+            _initiate_send{this}, handler);
+        }
+
+        struct file_transfer::_initiate_receive
+        {
+          file_transfer* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler) const
+          {
+            typedef typename std::decay<Handler>::type Completion;
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            auto& service = this->self->_socket.get_io_service();
+            this->self->_receive(
+              [h, &service] (system::error_code const& error,
+                             std::uint64_t size)
+              {
+                asio::post(service,
+                           asio::detail::bind_handler(std::move(*h),
+                                                      error, size));
+              });
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code,
+                                            std::uint64_t))
+        file_transfer::async_receive(Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, std::uint64_t)>(
+            _initiate_receive{this}, handler);
+        }
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cstring>
+
+#include <asio-udt/framed-socket.hh>
+
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("boost.asio.ip.udt.framed_socket");
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        static std::size_t const header_size = 4;
+
+        framed_socket::framed_socket(socket& sock,
+                                     std::size_t ring_size,
+                                     std::size_t max_frame)
+          : _socket(sock)
+          , _ring(std::max(ring_size, header_size))
+          , _begin(0)
+          , _end(0)
+          , _consumed(0)
+          , _max_frame(max_frame)
+        {}
+
+        io_service&
+        framed_socket::get_io_service()
+        {
+          return this->_socket.get_io_service();
+        }
+
+        std::size_t
+        framed_socket::buffered() const
+        {
+          return this->_end - this->_begin - this->_consumed;
+        }
+
+        void
+        framed_socket::_read_frame(Done done)
+        {
+          this->_begin += this->_consumed;
+          this->_consumed = 0;
+          if (this->_begin == this->_end)
+            this->_begin = this->_end = 0;
+          auto available = this->_end - this->_begin;
+          if (available >= header_size)
+          {
+            auto header = this->_ring.data() + this->_begin;
+            std::size_t size = 0;
+            for (std::size_t i = 0; i < header_size; ++i)
+              size = (size << 8) | static_cast<unsigned char>(header[i]);
+            if (size > this->_max_frame)
+            {
+              ELLE_WARN("reject frame of %s bytes", size);
+              return done(
+                system::errc::make_error_code(system::errc::bad_message),
+                const_buffer());
+            }
+            if (header_size + size <= available)
+            {
+              this->_consumed = header_size + size;
+              return done(system::error_code(),
+                          boost::asio::buffer(header + header_size, size));
+            }
+            if (header_size + size > this->_ring.size())
+            {
+              // Everything buffered belongs to this frame.
+              ELLE_DEBUG("receive frame of %s bytes out of the ring", size);
+              this->_large.resize(size);
+              auto offset = available - header_size;
+              std::memcpy(this->_large.data(), header + header_size, offset);
+              this->_begin = this->_end = 0;
+              return this->_read_large(offset, std::move(done));
+            }
+          }
+          // Make room for the rest of the partial frame.
+          if (this->_begin > 0)
+          {
+            std::memmove(this->_ring.data(),
+                         this->_ring.data() + this->_begin, available);
+            this->_begin = 0;
+            this->_end = available;
+          }
+          this->_socket.async_read_some(
+            boost::asio::buffer(this->_ring.data() + this->_end,
+                                this->_ring.size() - this->_end),
+            [this, done] (system::error_code const& error, std::size_t size)
+            {
+              if (error)
+                return done(error, const_buffer());
+              this->_end += size;
+              this->_read_frame(done);
+            });
+        }
+
+        std::vector<char>
+        framed_socket::_header(std::uint64_t size, Sent const& done)
+        {
+          if (size > 0xffffffff)
+          {
+            ELLE_WARN("reject frame of %s bytes", size);
+            done(boost::asio::error::message_size, 0);
+            return std::vector<char>();
+          }
+          std::vector<char> header(header_size);
+          for (std::size_t i = 0; i < header_size; ++i)
+            header[i] = (size >> (24 - 8 * i)) & 0xff;
+          return header;
+        }
+
+        /// Report the payload bytes sent, not the header ones.
+        static
+        std::function<void (system::error_code const&, std::size_t)>
+        payload(std::function<void (system::error_code const&,
+                                    std::size_t)> done)
+        {
+          return [done] (system::error_code const& error, std::size_t sent)
+          {
+            done(error, sent < header_size ? 0 : sent - header_size);
+          };
+        }
+
+        void
+        framed_socket::_write_frame(const_buffer buffer, Sent done)
+        {
+          auto header = _header(buffer_size(buffer), done);
+          if (header.empty())
+            return;
+          // Header and body go in a single send, so no other send can get
+          // in between, and errors are reported once. The body is sent
+          // from the caller memory, not copied.
+          this->_socket._send(std::move(header), buffer,
+                              payload(std::move(done)));
+        }
+
+        void
+        framed_socket::_write_frame(std::vector<char> frame, Sent done)
+        {
+          auto header = _header(frame.size(), done);
+          if (header.empty())
+            return;
+          this->_socket._send(std::move(header), std::move(frame),
+                              payload(std::move(done)));
+        }
+
+        void
+        framed_socket::_read_large(std::size_t offset, Done done)
+        {
+          if (offset == this->_large.size())
+            return done(system::error_code(),
+                        boost::asio::buffer(this->_large));
+          this->_socket.async_read_some(
+            boost::asio::buffer(this->_large.data() + offset,
+                                this->_large.size() - offset),
+            [this, offset, done] (system::error_code const& error,
+                                  std::size_t size)
+            {
+              if (error)
+                return done(error, const_buffer());
+              this->_read_large(offset + size, done);
+            });
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,110 @@
+#ifndef ASIO_UDT_FRAMED_SOCKET_HH
+# define ASIO_UDT_FRAMED_SOCKET_HH
+
+# include <cstdint>
+# include <functional>
+# include <utility>
+# include <vector>
+
+# include <boost/asio.hpp>
+# include <boost/noncopyable.hpp>
+
+# include <asio-udt/fwd.hh>
+# include <asio-udt/socket.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Length-prefixed messages over a connected socket: each frame is
+        /// preceded by its big endian 32-bit size.
+        ///
+        /// Data is received in bulk into a ring, so one receive usually
+        /// yields many small frames, which are then delivered without
+        /// touching the socket. Frames are handed out as views into the
+        /// ring: only frames larger than the ring are copied out, in a
+        /// buffer of their own.
+        class framed_socket: public boost::noncopyable
+        {
+          public:
+            /// Frame sock, which must outlive this. Frames larger than
+            /// max_frame are rejected with bad_message.
+            framed_socket(socket& sock,
+                          std::size_t ring_size = 256 * 1024,
+                          std::size_t max_frame = 64 * 1024 * 1024);
+
+          public:
+            /// Complete with the next frame. The view is valid until the
+            /// next async_read_frame.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                const_buffer))
+            async_read_frame(Handler&& handler);
+            /// Send buffer as one frame, through the socket send queue.
+            /// Completes with the size of buffer, or with message_size if
+            /// it does not fit the 32-bit header. The buffer is not copied:
+            /// it must remain valid until the handler is called.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::size_t))
+            async_write_frame(const_buffer buffer, Handler&& handler);
+            /// Send frame as one frame, taking ownership of it.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::size_t))
+            async_write_frame(std::vector<char> frame, Handler&& handler);
+            io_service&
+            get_io_service();
+            /// Bytes received but not delivered yet.
+            std::size_t
+            buffered() const;
+
+          private:
+            typedef std::function<void (system::error_code const&,
+                                        const_buffer)> Done;
+            typedef std::function<void (system::error_code const&,
+                                        std::size_t)> Sent;
+            struct _initiate_read_frame;
+            struct _initiate_write_frame;
+            void
+            _read_frame(Done done);
+            /// Receive the rest of a frame larger than the ring.
+            void
+            _read_large(std::size_t offset, Done done);
+            /// Queue header and body as a single send.
+            void
+            _write_frame(const_buffer buffer, Sent done);
+            void
+            _write_frame(std::vector<char> frame, Sent done);
+            /// The header of a frame of size bytes, or empty with done
+            /// failed if it does not fit.
+            static
+            std::vector<char>
+            _header(std::uint64_t size, Sent const& done);
+
+            socket& _socket;
+            std::vector<char> _ring;
+            /// Received bytes not delivered: [_begin, _end).
+            std::size_t _begin;
+            std::size_t _end;
+            /// Size of the frame last delivered from the ring, released on
+            /// the next read.
+            std::size_t _consumed;
+            std::size_t _max_frame;
+            std::vector<char> _large;
+        };
+      }
+    }
+  }
+}
+
+# include <asio-udt/framed-socket.hxx>
+
+#endif
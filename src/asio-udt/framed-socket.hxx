@@ -0,0 +1,100 @@
+#ifndef ASIO_UDT_FRAMED_SOCKET_HXX
+# define ASIO_UDT_FRAMED_SOCKET_HXX
+
+# include <memory>
+
+# include <boost/asio/async_result.hpp>
+# include <boost/asio/detail/bind_handler.hpp>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        struct framed_socket::_initiate_read_frame
+        {
+          framed_socket* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler) const
+          {
+            typedef typename std::decay<Handler>::type Completion;
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            auto& service = this->self->get_io_service();
+            this->self->_read_frame(
+              [h, &service] (system::error_code const& error,
+                             const_buffer frame)
+              {
+                asio::post(service,
+                           asio::detail::bind_handler(std::move(*h),
+                                                      error, frame));
+              });
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, const_buffer))
+        framed_socket::async_read_frame(Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, const_buffer)>(
+            _initiate_read_frame{this}, handler);
+        }
+
+        struct framed_socket::_initiate_write_frame
+        {
+          framed_socket* self;
+
+          template <typename Handler, typename Frame>
+          void
+          operator ()(Handler&& handler, Frame&& frame) const
+          {
+            typedef typename std::decay<Handler>::type Completion;
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            auto& service = this->self->get_io_service();
+            this->self->_write_frame(
+              std::forward<Frame>(frame),
+              [h, &service] (system::error_code const& error,
+                             std::size_t size)
+              {
+                asio::post(service,
+                           asio::detail::bind_handler(std::move(*h),
+                                                      error, size));
+              });
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, std::size_t))
+        framed_socket::async_write_frame(const_buffer buffer,
+                                         Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, std::size_t)>(
+            _initiate_write_frame{this}, handler, buffer);
+        }
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, std::size_t))
+        framed_socket::async_write_frame(std::vector<char> frame,
+                                         Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, std::size_t)>(
+            _initiate_write_frame{this}, handler, std::move(frame));
+        }
+      }
+    }
+  }
+}
+
+#endif
@@ -10,6 +10,14 @@ namespace boost
       namespace udt
       {
         class acceptor;
+        class broadcast;
+        class compressed_stream;
+        class connection_pool;
+        class dispatcher;
+        class file_transfer;
+        class framed_socket;
+        class recorder;
+        class replay;
         class service;
         class socket;
       }
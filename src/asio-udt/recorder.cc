@@ -0,0 +1,145 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include <boost/system/system_error.hpp>
+
+#include <asio-udt/recorder.hh>
+
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("boost.asio.ip.udt.recorder");
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Trace file header: magic, version, record size and count.
+        static char const magic[4] = {'U', 'D', 'T', 'R'};
+        static std::uint32_t const version = 1;
+
+        static_assert(sizeof(recorder::event) == 32,
+                      "trace records must be packed");
+
+        static
+        void
+        throw_file(std::string const& path)
+        {
+          throw system::system_error(
+            system::error_code(errno ? errno : EIO, system::system_category()),
+            path);
+        }
+
+        recorder::recorder(std::size_t capacity)
+          : _next(0)
+          , _start(Clock::now())
+        {
+          std::size_t size = 1;
+          while (size < capacity)
+            size <<= 1;
+          this->_ring.resize(size);
+        }
+
+        void
+        recorder::record(kind kind, queue queue, int fd,
+                         std::uint64_t operation, int value)
+        {
+          auto index = this->_next.fetch_add(1, std::memory_order_relaxed);
+          auto& event = this->_ring[index & (this->_ring.size() - 1)];
+          event.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - this->_start).count();
+          event.operation = operation;
+          event.fd = fd;
+          event.value = value;
+          event.kind = kind;
+          event.queue = queue;
+          event.padding = 0;
+        }
+
+        std::vector<recorder::event>
+        recorder::events() const
+        {
+          std::uint64_t end = this->_next.load(std::memory_order_acquire);
+          std::uint64_t size = this->_ring.size();
+          std::uint64_t begin = end > size ? end - size : 0;
+          std::vector<event> res;
+          res.reserve(end - begin);
+          for (auto i = begin; i < end; ++i)
+            res.push_back(this->_ring[i & (size - 1)]);
+          return res;
+        }
+
+        std::uint64_t
+        recorder::recorded() const
+        {
+          return this->_next.load(std::memory_order_relaxed);
+        }
+
+        std::size_t
+        recorder::capacity() const
+        {
+          return this->_ring.size();
+        }
+
+        void
+        recorder::save(std::string const& path) const
+        {
+          auto events = this->events();
+          ELLE_TRACE("save %s events to %s", events.size(), path);
+          errno = 0;
+          std::ofstream file(path, std::ios::out | std::ios::binary |
+                             std::ios::trunc);
+          if (!file)
+            throw_file(path);
+          std::uint32_t size = sizeof(event);
+          std::uint64_t count = events.size();
+          file.write(magic, sizeof(magic));
+          file.write(reinterpret_cast<char const*>(&version), sizeof(version));
+          file.write(reinterpret_cast<char const*>(&size), sizeof(size));
+          file.write(reinterpret_cast<char const*>(&count), sizeof(count));
+          file.write(reinterpret_cast<char const*>(events.data()),
+                     count * sizeof(event));
+          file.flush();
+          if (!file)
+            throw_file(path);
+        }
+
+        std::vector<recorder::event>
+        recorder::load(std::string const& path)
+        {
+          errno = 0;
+          std::ifstream file(path, std::ios::in | std::ios::binary);
+          if (!file)
+            throw_file(path);
+          char m[sizeof(magic)];
+          std::uint32_t v = 0;
+          std::uint32_t size = 0;
+          std::uint64_t count = 0;
+          file.read(m, sizeof(m));
+          file.read(reinterpret_cast<char*>(&v), sizeof(v));
+          file.read(reinterpret_cast<char*>(&size), sizeof(size));
+          file.read(reinterpret_cast<char*>(&count), sizeof(count));
+          if (!file || std::memcmp(m, magic, sizeof(magic)) != 0 ||
+              v != version || size != sizeof(event))
+            throw system::system_error(
+              system::errc::make_error_code(system::errc::bad_message), path);
+          std::vector<event> res;
+          // Do not trust count with the allocation size.
+          event e;
+          while (res.size() < count &&
+                 file.read(reinterpret_cast<char*>(&e), sizeof(e)))
+            res.push_back(e);
+          if (res.size() != count)
+            throw system::system_error(
+              system::errc::make_error_code(system::errc::bad_message), path);
+          ELLE_TRACE("load %s events from %s", res.size(), path);
+          return res;
+        }
+      }
+    }
+  }
+}
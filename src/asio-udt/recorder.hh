@@ -0,0 +1,110 @@
+#ifndef ASIO_UDT_RECORDER_HH
+# define ASIO_UDT_RECORDER_HH
+
+# include <atomic>
+# include <chrono>
+# include <cstdint>
+# include <string>
+# include <vector>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Trace of the reactor activity of a service, for offline replay.
+        ///
+        /// Events are stored in a fixed size ring, the oldest being
+        /// overwritten: recording is a few stores, without allocation nor
+        /// lock. The service records under its lock, a recorder is best
+        /// attached to a single service.
+        class recorder
+        {
+          public:
+            typedef std::chrono::steady_clock Clock;
+
+            enum kind
+            {
+              /// An operation is registered. Value is its timeout in
+              /// milliseconds, negative if none.
+              registration,
+              /// An operation is cancelled, any operation on fd if 0.
+              cancellation,
+              /// The reactor is about to wait. Value is the epoll timeout in
+              /// milliseconds, negative if none.
+              wait,
+              /// The reactor woke up. Value is the number of epoll events,
+              /// recorded as ready events right after.
+              wakeup,
+              /// Fd is ready. Drains are recorded as they complete.
+              ready,
+              /// An operation timed out.
+              expiry,
+              /// The epoll registration of fd is refreshed, queue being read
+              /// for UDT sockets and system_read for system fds. Value is
+              /// the UDT epoll flags, 0 if unregistered.
+              refresh,
+            };
+
+            /// Operation queue of the service.
+            enum queue
+            {
+              read,
+              write,
+              drain,
+              system_read,
+              system_write,
+            };
+
+            /// Fixed size record, as stored in trace files.
+            struct event
+            {
+              /// Nanoseconds since the recorder was created.
+              std::uint64_t time;
+              /// Operation identifier, 0 if not relevant.
+              std::uint64_t operation;
+              std::int32_t fd;
+              std::int32_t value;
+              std::uint8_t kind;
+              std::uint8_t queue;
+              std::uint16_t padding;
+            };
+
+          public:
+            /// Keep the last capacity events, rounded up to a power of two.
+            recorder(std::size_t capacity = 1 << 16);
+
+          public:
+            void
+            record(kind kind, queue queue, int fd,
+                   std::uint64_t operation = 0, int value = 0);
+            /// Recorded events still in the ring, oldest first.
+            std::vector<event>
+            events() const;
+            /// Events recorded so far, overwritten ones included.
+            std::uint64_t
+            recorded() const;
+            std::size_t
+            capacity() const;
+            /// Write events() to path.
+            void
+            save(std::string const& path) const;
+            /// Read the events saved in path.
+            static
+            std::vector<event>
+            load(std::string const& path);
+
+          private:
+            std::vector<event> _ring;
+            std::atomic<std::uint64_t> _next;
+            Clock::time_point _start;
+        };
+      }
+    }
+  }
+}
+
+#endif
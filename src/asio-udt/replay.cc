@@ -0,0 +1,196 @@
+#include <unordered_map>
+
+#include <asio-udt/replay.hh>
+#include <asio-udt/service.hh>
+
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("boost.asio.ip.udt.replay");
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        replay::result::result()
+          : elapsed(0)
+          , registrations(0)
+          , cancellations(0)
+          , wakeups(0)
+          , ready(0)
+          , lost(0)
+        {}
+
+        replay::replay(std::vector<recorder::event> events)
+          : _events(std::move(events))
+        {}
+
+        std::vector<recorder::event> const&
+        replay::events() const
+        {
+          return this->_events;
+        }
+
+        replay::result
+        replay::run(std::shared_ptr<recorder> const& record) const
+        {
+          ELLE_TRACE_SCOPE("replay %s events", this->_events.size());
+          io_service io_service;
+          // Polled, with a poll deemed scheduled: nothing but the replay
+          // drives the reactor.
+          auto s = new service(io_service, service::polled);
+          add_service(io_service, s);
+          s->_offline = true;
+          s->_replayed = timing_wheel::Clock::now();
+          s->_polling = true;
+          if (record)
+            s->recorder(record);
+          auto map = [s] (int queue) -> service::Map&
+            {
+              switch (queue)
+              {
+                case recorder::write:
+                  return s->_write_map;
+                case recorder::drain:
+                  return s->_drain_map;
+                case recorder::system_read:
+                  return s->_sys_read_map;
+                case recorder::system_write:
+                  return s->_sys_write_map;
+                default:
+                  return s->_read_map;
+              }
+            };
+          auto wait = [s] (int queue) -> std::set<int>*
+            {
+              switch (queue)
+              {
+                case recorder::write:
+                  return &s->_wait_write;
+                case recorder::drain:
+                  return nullptr;
+                case recorder::system_read:
+                  return &s->_sys_wait_read;
+                case recorder::system_write:
+                  return &s->_sys_wait_write;
+                default:
+                  return &s->_wait_read;
+              }
+            };
+          service::Action action = [] {};
+          service::Cancel cancel = [] (system::error_code const&) {};
+          // Recorded operation identifiers to replayed ones.
+          std::unordered_map<std::uint64_t, service::Operation> operations;
+          auto operation = [&] (std::uint64_t recorded) -> service::Operation
+            {
+              if (recorded == 0)
+                return 0;
+              auto it = operations.find(recorded);
+              // Never matches: the operation was registered before the
+              // trace starts.
+              return it == operations.end() ? ~service::Operation(0) :
+                it->second;
+            };
+          result res;
+          auto& events = this->_events;
+          // The service clock follows the trace, from now on.
+          auto origin = timing_wheel::Clock::now();
+          auto first = events.empty() ? 0 : events.front().time;
+          auto start = std::chrono::steady_clock::now();
+          for (std::size_t i = 0; i < events.size(); ++i)
+          {
+            auto const& e = events[i];
+            s->_replayed = origin + std::chrono::nanoseconds(e.time - first);
+            if (e.kind == recorder::registration)
+            {
+              auto timeout = e.value < 0 ?
+                posix_time::time_duration(posix_time::pos_infin) :
+                posix_time::milliseconds(e.value);
+              boost::unique_lock<boost::mutex> lock(s->_lock);
+              operations[e.operation] =
+                s->_register(map(e.queue), wait(e.queue), e.fd,
+                             action, cancel, timeout, service::Invoker());
+              ++res.registrations;
+            }
+            else if (e.kind == recorder::cancellation)
+            {
+              s->_cancel(map(e.queue), wait(e.queue), e.fd,
+                         operation(e.operation));
+              ++res.cancellations;
+            }
+            else if (e.kind == recorder::wakeup)
+            {
+              std::set<UDTSOCKET> readfds;
+              std::set<UDTSOCKET> writefds;
+              std::set<SYSSOCKET> sysfds;
+              std::set<SYSSOCKET> syswritefds;
+              std::vector<recorder::event const*> expired;
+              // Ready events follow their wakeup, then drains, expiries
+              // and refreshes happen as the wakeup is processed.
+              for (; i + 1 < events.size(); ++i)
+              {
+                auto const& next = events[i + 1];
+                if (next.kind == recorder::expiry)
+                  expired.push_back(&next);
+                else if (next.kind == recorder::ready)
+                {
+                  if (next.queue == recorder::drain)
+                    s->_drained.insert(next.fd);
+                  else
+                  {
+                    auto& m = map(next.queue);
+                    if (m.find(next.fd) == m.end())
+                      ++res.lost;
+                    switch (next.queue)
+                    {
+                      case recorder::read:
+                        readfds.insert(next.fd);
+                        break;
+                      case recorder::write:
+                        writefds.insert(next.fd);
+                        break;
+                      case recorder::system_read:
+                        sysfds.insert(next.fd);
+                        break;
+                      default:
+                        syswritefds.insert(next.fd);
+                    }
+                  }
+                }
+                else if (next.kind != recorder::refresh)
+                  break;
+              }
+              service::Ready ready;
+              s->_process(readfds, writefds, sysfds, syswritefds, ready);
+              res.ready += ready.size();
+              s->_drained.clear();
+              for (auto expiry: expired)
+              {
+                auto& m = map(expiry->queue);
+                auto it = m.find(expiry->fd);
+                auto op = operation(expiry->operation);
+                if (it == m.end() || it->second.operation != op)
+                  continue;
+                s->_cancel(m, wait(expiry->queue), expiry->fd, op);
+                ++res.ready;
+              }
+              ++res.wakeups;
+              // Run the posted cancel completions.
+              io_service.poll();
+              io_service.restart();
+            }
+          }
+          io_service.poll();
+          res.elapsed = std::chrono::steady_clock::now() - start;
+          ELLE_TRACE("replayed %s wakeups in %s us", res.wakeups,
+                     std::chrono::duration_cast<std::chrono::microseconds>(
+                       res.elapsed).count());
+          return res;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,65 @@
+#ifndef ASIO_UDT_REPLAY_HH
+# define ASIO_UDT_REPLAY_HH
+
+# include <chrono>
+# include <cstdint>
+# include <memory>
+# include <vector>
+
+# include <asio-udt/fwd.hh>
+# include <asio-udt/recorder.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Drive the reactor data structures of a service through a
+        /// recorded trace, offline.
+        ///
+        /// Registrations and cancellations are issued as recorded, and
+        /// wakeups are fed the recorded epoll results. No socket exists and
+        /// UDT is only called to create the epoll set of the service: the
+        /// cost measured is the reactor bookkeeping only. The trace is
+        /// replayed as fast as possible, against a clock that follows the
+        /// recorded timestamps, so timeouts expire as recorded.
+        class replay
+        {
+          public:
+            struct result
+            {
+              result();
+              /// Time spent replaying.
+              std::chrono::steady_clock::duration elapsed;
+              std::uint64_t registrations;
+              std::uint64_t cancellations;
+              std::uint64_t wakeups;
+              /// Actions made ready, timeouts included.
+              std::uint64_t ready;
+              /// Ready events for fds without pending operation.
+              std::uint64_t lost;
+            };
+
+          public:
+            replay(std::vector<recorder::event> events);
+
+          public:
+            /// Replay the trace on a fresh service, recording its activity
+            /// to record if not null.
+            result
+            run(std::shared_ptr<recorder> const& record = nullptr) const;
+            std::vector<recorder::event> const&
+            events() const;
+
+          private:
+            std::vector<recorder::event> _events;
+        };
+      }
+    }
+  }
+}
+
+#endif
@@ -1,6 +1,14 @@
+#include <algorithm>
+
+#include <asio-udt/affinity.hh>
+#include <asio-udt/dispatcher.hh>
 #include <asio-udt/error-category.hh>
 #include <asio-udt/service.hh>
 #include <asio-udt/socket.hh>
+#include <asio-udt/statistics.hh>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <elle/log.hh>
 
@@ -26,15 +34,82 @@ namespace boost
       {
         io_service::id service::id;
 
-        service::service(io_service& io_service)
+        /// Interval, in milliseconds, at which send buffers are checked for
+        /// pending drains.
+        static const int drain_poll_interval = 10;
+        /// Resolution of operation timeouts, UDT epoll does not wake up
+        /// more often anyway.
+        static const int deadline_resolution = 10;
+        /// Interval, in milliseconds, at which sending sockets are checked
+        /// for having stopped, to share the bandwidth budget again.
+        static const int schedule_interval = 100;
+        /// Interval, in milliseconds, between polls finding nothing ready
+        /// in polled mode, so idle operations do not spin io_service threads.
+        static const int poll_backoff = 1;
+        /// Deadline wheel key of the schedule timer: operations start at 1.
+        static const timing_wheel::Key schedule_key = 0;
+
+        /// Autotuned buffer size for unknown peers, and bounds.
+        static const std::size_t autotune_default = 256 * 1024;
+        static const std::size_t autotune_min = 64 * 1024;
+        static const std::size_t autotune_max = 64 * 1024 * 1024;
+        /// Number of peers whose estimates are remembered.
+        static const std::size_t autotune_peers = 4096;
+
+        /// Lock mutex, recording how long it took.
+        static
+        boost::unique_lock<boost::mutex>
+        acquire(boost::mutex& mutex)
+        {
+          if (!instrument::enabled())
+            return boost::unique_lock<boost::mutex>(mutex);
+          boost::unique_lock<boost::mutex> lock(mutex, boost::try_to_lock);
+          if (lock.owns_lock())
+            instrument::lock_wait(instrument::Duration::zero());
+          else
+          {
+            auto start = timing_wheel::Clock::now();
+            lock.lock();
+            instrument::lock_wait(timing_wheel::Clock::now() - start);
+          }
+          return lock;
+        }
+
+        service::service(io_service& io_service, mode mode)
           : io_service::service(io_service)
-          , _epoll(UDT::epoll_create())
+          , _mode(mode)
+          , _operation(0)
+          , _epoll(mode == shared ?
+                   dispatcher::instance().epoll() : UDT::epoll_create())
           , _thread(nullptr)
+          , _busy_poll(0)
+          , _cpu(-1)
+          , _udt_cpu(-1)
+          , _offline(false)
           , _stop(false)
+          , _polling(false)
+          , _poll_timer(io_service)
+          , _poll_idle(false)
+          , _batch(0)
+          , _bandwidth(-1)
+          , _active_flows(0)
+          , _autotune(0)
+          , _autotuned(0)
+          , _deadlines(std::chrono::milliseconds(deadline_resolution))
+          , _wait_deadline(timing_wheel::Clock::time_point::max())
         {
-          // Create the thread after all members have been initialized.
-          this->_thread.reset(
-            new boost::thread(std::bind(&service::_run, this)));
+          if (this->_mode == shared)
+          {
+            this->_interrupt[0] = this->_interrupt[1] = -1;
+            dispatcher::instance().add(this);
+            return;
+          }
+          if (::pipe(this->_interrupt) == -1)
+            throw_errno();
+          ::fcntl(this->_interrupt[0], F_SETFL, O_NONBLOCK);
+          ::fcntl(this->_interrupt[1], F_SETFL, O_NONBLOCK);
+          int flags = UDT_EPOLL_IN;
+          UDT::epoll_add_ssock(this->_epoll, this->_interrupt[0], &flags);
         }
 
         service::~service()
@@ -48,54 +123,145 @@ namespace boost
         service::shutdown_service()
         {
           {
-            boost::unique_lock<boost::mutex> lock(_lock);
+            auto lock = acquire(this->_lock);
             if (_stop)
               return;
-            UDT::epoll_release(_epoll);
+            if (this->_mode != shared)
+              UDT::epoll_release(_epoll);
             _barrier.notify_one();
             _stop = true;
           }
-          this->_thread->join();
+          if (this->_mode == shared)
+            dispatcher::instance().remove(this);
+          if (this->_thread)
+            this->_thread->join();
+          {
+            boost::unique_lock<boost::mutex> lock(_reap_lock);
+            _reap_barrier.notify_one();
+          }
+          if (this->_reaper)
+            this->_reaper->join();
+          if (this->_mode != shared)
+          {
+            ::close(this->_interrupt[0]);
+            ::close(this->_interrupt[1]);
+          }
+          // Destroyed outside the lock.
+          std::unordered_map<void*, std::shared_ptr<void>> retained;
+          {
+            boost::unique_lock<boost::mutex> lock(this->_retained_lock);
+            std::swap(retained, this->_retained);
+          }
+        }
+
+        void
+        service::_retain(std::shared_ptr<void> object)
+        {
+          boost::unique_lock<boost::mutex> lock(this->_retained_lock);
+          auto key = object.get();
+          this->_retained.emplace(key, std::move(object));
+        }
+
+        std::shared_ptr<void>
+        service::_release(void* object)
+        {
+          boost::unique_lock<boost::mutex> lock(this->_retained_lock);
+          auto it = this->_retained.find(object);
+          if (it == this->_retained.end())
+            return nullptr;
+          auto res = std::move(it->second);
+          this->_retained.erase(it);
+          return res;
+        }
+
+        void
+        service::_wakeup()
+        {
+          // Pollers never block.
+          if (this->_mode == polled)
+            return;
+          if (this->_mode == shared)
+            return dispatcher::instance().wakeup();
+          char c = 0;
+          // A full pipe already guarantees a wakeup.
+          if (::write(this->_interrupt[1], &c, 1) == -1)
+            ELLE_DUMP("%s: wakeup already pending", *this);
         }
 
         void
         service::_run()
         {
+          int pinned = -1;
           while (true)
           {
             std::set<UDTSOCKET> readfds;
             std::set<UDTSOCKET> writefds;
+            std::set<SYSSOCKET> sysfds;
+            std::set<SYSSOCKET> syswritefds;
+            int cpu = this->_cpu;
+            if (cpu != pinned && cpu >= 0 && pin_thread(cpu))
+              pinned = cpu;
             while (true)
             {
+              int timeout = -1;
               ELLE_TRACE("%s: wait for socket event", *this)
               {
-                boost::unique_lock<boost::mutex> lock(_lock);
+                auto lock = acquire(this->_lock);
                 for (auto r: _read_map)
                   ELLE_DUMP("%s: monitor %s for read", *this, r.first);
                 for (auto w: _write_map)
                   ELLE_DUMP("%s: monitor %s for write", *this, w.first);
+                for (auto r: _sys_read_map)
+                  ELLE_DUMP("%s: monitor fd %s for read", *this, r.first);
+                for (auto w: _sys_write_map)
+                  ELLE_DUMP("%s: monitor fd %s for write", *this, w.first);
+                timeout = this->_timeout();
               }
-              if (UDT::epoll_wait(this->_epoll, &readfds, &writefds, -1) < 0)
+              std::chrono::microseconds budget(this->_busy_poll);
+              if (budget.count() > 0 &&
+                  this->_spin(readfds, writefds, sysfds, syswritefds,
+                              budget, timeout))
+                break;
+              if (UDT::epoll_wait(this->_epoll, &readfds, &writefds,
+                                  timeout, &sysfds, &syswritefds) < 0)
               {
                 if (_stop)
                 {
                   ELLE_TRACE("%s: stop service", *this);
                   return;
                 }
-                if (UDT::getlasterror().getErrorCode() ==
-                    udt_category::EINVPARAM)
+                auto code = UDT::getlasterror().getErrorCode();
+                if (code == udt_category::ETIMEOUT)
+                  break;
+                else if (code == udt_category::EINVPARAM)
                 {
                   ELLE_DEBUG("%s: no socket to wait upon, waiting", *this);
-                  boost::unique_lock<boost::mutex> lock(_lock);
-                  while (_read_map.empty() && _write_map.empty())
+                  auto lock = acquire(this->_lock);
+                  bool timed = false;
+                  // An earlier deadline, as the schedule timer, calls for
+                  // a new timeout.
+                  while (_read_map.empty() && _write_map.empty() &&
+                         _sys_read_map.empty() && _sys_write_map.empty() &&
+                         this->_deadlines.next() >= this->_wait_deadline)
                   {
-                    _barrier.wait(lock);
+                    if (timeout >= 0)
+                    {
+                      _barrier.wait_for(
+                        lock, boost::chrono::milliseconds(timeout));
+                      timed = true;
+                    }
+                    else
+                      _barrier.wait(lock);
                     if (_stop)
                     {
                       ELLE_TRACE("%s: stop service", *this);
                       return;
                     }
+                    if (timed)
+                      break;
                   }
+                  if (timed)
+                    break;
                 }
                 else
                   throw_udt();
@@ -109,50 +275,488 @@ namespace boost
                 else
                   break;
             }
-            ELLE_DEBUG("%s: got %s read events and %s write events",
-                       *this, readfds.size(), writefds.size());
-            boost::unique_lock<boost::mutex> lock(_lock);
-            for (auto read: readfds)
+            auto now = timing_wheel::Clock::now();
+            instrument::wakeup(readfds.size() + writefds.size() +
+                               sysfds.size() + syswritefds.size());
+            this->_dispatch(readfds, writefds, sysfds, syswritefds, now);
+          }
+        }
+
+        bool
+        service::_spin(std::set<UDTSOCKET>& readfds,
+                       std::set<UDTSOCKET>& writefds,
+                       std::set<SYSSOCKET>& sysfds,
+                       std::set<SYSSOCKET>& syswritefds,
+                       std::chrono::microseconds budget,
+                       int timeout)
+        {
+          auto start = timing_wheel::Clock::now();
+          auto until = start + budget;
+          // Do not spin past the next deadline.
+          if (timeout >= 0)
+            until = std::min(until, start + std::chrono::milliseconds(timeout));
+          do
+          {
+            if (UDT::epoll_wait(this->_epoll, &readfds, &writefds,
+                                0, &sysfds, &syswritefds) > 0)
+              return true;
+            // Nothing is monitored: block on the barrier instead.
+            if (this->_stop || UDT::getlasterror().getErrorCode() ==
+                udt_category::EINVPARAM)
+              return false;
+          }
+          while (timing_wheel::Clock::now() < until);
+          return false;
+        }
+
+        void
+        service::_dispatch(std::set<UDTSOCKET> const& readfds,
+                           std::set<UDTSOCKET> const& writefds,
+                           std::set<SYSSOCKET> const& sysfds,
+                           std::set<SYSSOCKET> const& syswritefds,
+                           timing_wheel::Clock::time_point now)
+        {
+          Ready ready;
+          this->_process(readfds, writefds, sysfds, syswritefds, ready);
+          std::size_t batch = this->_batch;
+          if (batch == 0 || ready.size() == 1)
+            for (auto const& action: ready)
+              this->_post(action.first, action.second, now);
+          else if (!ready.empty())
+          {
+            auto chunks = std::make_shared<Ready>(std::move(ready));
+            ELLE_DEBUG("%s: post %s ready actions in chunks of %s",
+                       *this, chunks->size(), batch);
+            for (std::size_t begin = 0; begin < chunks->size();
+                 begin += batch)
+              this->get_io_context().post(
+                std::bind(&service::_run_ready, this, chunks, begin,
+                          std::min(begin + batch, chunks->size()), now));
+          }
+        }
+
+        void
+        service::_run_ready(std::shared_ptr<Ready> const& ready,
+                            std::size_t begin, std::size_t end,
+                            timing_wheel::Clock::time_point ready_at)
+        {
+          for (auto i = begin; i < end; ++i)
+          {
+            auto& action = (*ready)[i];
+            if (instrument::enabled())
+              instrument::dispatch_delay(
+                timing_wheel::Clock::now() - ready_at);
+            try
             {
-              auto it = _read_map.find(read);
-              if (it != _read_map.end())
-              {
-                ELLE_DEBUG("%s: execute read action for %s", *this, read);
-                // static int const flags = UDT_EPOLL_IN;
-                this->_wait_read.erase(read);
-                this->_wait_refresh(read);
-                this->get_io_service().post(it->second.action);
-                _read_map.erase(it);
-              }
-              // else
-              //   ASIO_UDT_DEBUG("LOST READ " << read);
+              if (action.second)
+                action.second(action.first);
+              else
+                action.first();
             }
-            for (auto write: writefds)
+            catch (...)
             {
-              auto it = _write_map.find(write);
-              if (it != _write_map.end())
+              // Let the exception out of the io_service like any handler,
+              // without dropping the rest of the chunk.
+              if (i + 1 < end)
+                this->get_io_context().post(
+                  std::bind(&service::_run_ready, this, ready, i + 1, end,
+                            ready_at));
+              throw;
+            }
+          }
+        }
+
+        void
+        service::_start()
+        {
+          // Start the reactor on demand, services may never need it.
+          if (this->_mode == threaded && !this->_thread)
+            this->_thread.reset(
+              new boost::thread(std::bind(&service::_run, this)));
+          else if (this->_mode == shared)
+            dispatcher::instance().start();
+          if (this->_mode == polled)
+          {
+            if (!this->_polling)
+            {
+              this->_polling = true;
+              this->get_io_context().post(std::bind(&service::_poll, this));
+            }
+            else if (this->_poll_idle)
+            {
+              // Poll right away for the newcomer.
+              this->_poll_idle = false;
+              this->_poll_timer.cancel();
+            }
+          }
+        }
+
+        void
+        service::_poll()
+        {
+          if (_stop)
+            return;
+          std::set<UDTSOCKET> readfds;
+          std::set<UDTSOCKET> writefds;
+          std::set<SYSSOCKET> sysfds;
+          std::set<SYSSOCKET> syswritefds;
+          if (UDT::epoll_wait(this->_epoll, &readfds, &writefds,
+                              0, &sysfds, &syswritefds) < 0)
+          {
+            auto code = UDT::getlasterror().getErrorCode();
+            if (code != udt_category::ETIMEOUT &&
+                code != udt_category::EINVPARAM)
+              // No exception out of the io_service: polling could never
+              // resume.
+              return this->_fail(udt_error());
+          }
+          auto now = timing_wheel::Clock::now();
+          instrument::wakeup(readfds.size() + writefds.size() +
+                             sysfds.size() + syswritefds.size());
+          Ready ready;
+          this->_process(readfds, writefds, sysfds, syswritefds, ready);
+          bool pending;
+          {
+            auto lock = acquire(this->_lock);
+            // Active flows need the schedule timer to expire.
+            pending = !(this->_read_map.empty() &&
+                        this->_write_map.empty() &&
+                        this->_drain_map.empty() &&
+                        this->_sys_read_map.empty() &&
+                        this->_sys_write_map.empty()) ||
+              this->_active_flows > 0;
+            this->_polling = pending;
+            // Nothing happened: back off instead of spinning, until the
+            // next deadline at most or a new registration.
+            this->_poll_idle = pending && ready.empty();
+            if (this->_poll_idle)
+            {
+              this->_poll_timer.expires_at(
+                std::min(now + std::chrono::milliseconds(poll_backoff),
+                         this->_deadlines.next()));
+              this->_poll_timer.async_wait(
+                [this] (system::error_code const&)
+                {
+                  this->_poll();
+                });
+              return;
+            }
+          }
+          // Repost first so other threads keep polling while this one runs
+          // the ready actions.
+          if (pending)
+            this->get_io_context().post(std::bind(&service::_poll, this));
+          if (!ready.empty())
+          {
+            auto size = ready.size();
+            this->_run_ready(std::make_shared<Ready>(std::move(ready)),
+                             0, size, now);
+          }
+        }
+
+        void
+        service::_fail(system::error_code const& error)
+        {
+          ELLE_WARN("%s: reactor failure: %s", *this, error.message());
+          Ready failed;
+          {
+            auto lock = acquire(this->_lock);
+            auto fail = [&] (Map& map, std::set<int>* wait)
               {
-                ELLE_DEBUG("%s: execute write action for %s", *this, write);
-                // static int const flags = UDT_EPOLL_OUT;
-                this->_wait_write.erase(write);
-                this->_wait_refresh(write);
-                this->get_io_service().post(it->second.action);
-                _write_map.erase(it);
-              }
-              // else
-              //   ASIO_UDT_DEBUG("LOST WRITE " << write);
+                for (auto& work: map)
+                {
+                  this->_untime(work.second.operation);
+                  failed.emplace_back(std::bind(work.second.cancel, error),
+                                      std::move(work.second.invoker));
+                  if (wait)
+                  {
+                    wait->erase(work.first);
+                    this->_refresh(wait, work.first);
+                  }
+                }
+                map.clear();
+              };
+            fail(this->_read_map, &this->_wait_read);
+            fail(this->_write_map, &this->_wait_write);
+            fail(this->_drain_map, nullptr);
+            fail(this->_sys_read_map, &this->_sys_wait_read);
+            fail(this->_sys_write_map, &this->_sys_wait_write);
+            // The next registration starts polling again.
+            this->_polling = false;
+            this->_poll_idle = false;
+          }
+          // Never run user code under the reactor lock.
+          for (auto const& action: failed)
+            this->_post(action.first, action.second);
+        }
+
+        void
+        service::_process(std::set<UDTSOCKET> const& readfds,
+                          std::set<UDTSOCKET> const& writefds,
+                          std::set<SYSSOCKET> const& sysfds,
+                          std::set<SYSSOCKET> const& syswritefds,
+                          Ready& ready)
+        {
+          ELLE_DEBUG("%s: got %s read events and %s write events",
+                     *this, readfds.size(), writefds.size());
+          if (sysfds.find(this->_interrupt[0]) != sysfds.end())
+          {
+            char buffer[64];
+            while (::read(this->_interrupt[0], buffer, sizeof(buffer)) > 0)
+              ;
+          }
+          auto lock = acquire(this->_lock);
+          if (this->_recorder)
+          {
+            this->_record(udt::recorder::wakeup, udt::recorder::read, -1, 0,
+                          readfds.size() + writefds.size() +
+                          sysfds.size() + syswritefds.size());
+            this->_record(readfds, udt::recorder::read);
+            this->_record(writefds, udt::recorder::write);
+            this->_record(sysfds, udt::recorder::system_read);
+            this->_record(syswritefds, udt::recorder::system_write);
+          }
+          for (auto read: readfds)
+          {
+            auto it = _read_map.find(read);
+            if (it != _read_map.end())
+            {
+              ELLE_DEBUG("%s: execute read action for %s", *this, read);
+              // static int const flags = UDT_EPOLL_IN;
+              this->_wait_read.erase(read);
+              this->_wait_refresh(read);
+              this->_untime(it->second.operation);
+              ready.emplace_back(std::move(it->second.action),
+                                 std::move(it->second.invoker));
+              _read_map.erase(it);
+            }
+            // else
+            //   ASIO_UDT_DEBUG("LOST READ " << read);
+          }
+          for (auto write: writefds)
+          {
+            auto it = _write_map.find(write);
+            if (it != _write_map.end())
+            {
+              ELLE_DEBUG("%s: execute write action for %s", *this, write);
+              // static int const flags = UDT_EPOLL_OUT;
+              this->_wait_write.erase(write);
+              this->_wait_refresh(write);
+              this->_untime(it->second.operation);
+              ready.emplace_back(std::move(it->second.action),
+                                 std::move(it->second.invoker));
+              _write_map.erase(it);
+            }
+            // else
+            //   ASIO_UDT_DEBUG("LOST WRITE " << write);
+          }
+          // The self-pipe is never registered, and fds may have been
+          // unregistered since the wait: only act upon registered fds.
+          for (auto fd: sysfds)
+          {
+            auto it = _sys_read_map.find(fd);
+            if (it == _sys_read_map.end())
+              continue;
+            ELLE_DEBUG("%s: execute read action for fd %s", *this, fd);
+            this->_sys_wait_read.erase(fd);
+            this->_sys_wait_refresh(fd);
+            this->_untime(it->second.operation);
+            ready.emplace_back(std::move(it->second.action),
+                               std::move(it->second.invoker));
+            _sys_read_map.erase(it);
+          }
+          for (auto fd: syswritefds)
+          {
+            auto it = _sys_write_map.find(fd);
+            if (it == _sys_write_map.end())
+              continue;
+            ELLE_DEBUG("%s: execute write action for fd %s", *this, fd);
+            this->_sys_wait_write.erase(fd);
+            this->_sys_wait_refresh(fd);
+            this->_untime(it->second.operation);
+            ready.emplace_back(std::move(it->second.action),
+                               std::move(it->second.invoker));
+            _sys_write_map.erase(it);
+          }
+          this->_poll_drains(ready);
+          this->_expire(ready);
+        }
+
+        int
+        service::_timeout()
+        {
+          auto now = this->_now();
+          auto deadline = this->_deadlines.next();
+          if (!this->_drain_map.empty())
+            deadline = std::min(
+              deadline, now + std::chrono::milliseconds(drain_poll_interval));
+          this->_wait_deadline = deadline;
+          int res;
+          if (deadline == timing_wheel::Clock::time_point::max())
+            res = -1;
+          else if (deadline <= now)
+            res = 0;
+          else
+            // Round up, waking up early would be a wasted wakeup.
+            res = (deadline - now + std::chrono::milliseconds(1) -
+                   std::chrono::nanoseconds(1)) / std::chrono::milliseconds(1);
+          this->_record(udt::recorder::wait, udt::recorder::read, -1, 0, res);
+          return res;
+        }
+
+        timing_wheel::Clock::time_point
+        service::_now() const
+        {
+          if (this->_offline)
+            return this->_replayed;
+          return timing_wheel::Clock::now();
+        }
+
+        void
+        service::_expire(Ready& ready)
+        {
+          this->_wait_deadline = timing_wheel::Clock::time_point::max();
+          std::vector<timing_wheel::Key> expired;
+          this->_deadlines.advance(this->_now(), expired);
+          for (auto operation: expired)
+          {
+            if (operation == schedule_key)
+            {
+              this->_schedule();
+              continue;
+            }
+            auto deadline = this->_timeouts.find(operation);
+            if (deadline == this->_timeouts.end())
+              continue;
+            auto& map = *deadline->second.map;
+            auto sock = deadline->second.socket;
+            auto wait = deadline->second.wait;
+            this->_timeouts.erase(deadline);
+            auto work = map.find(sock);
+            if (work == map.end() || work->second.operation != operation)
+              continue;
+            ELLE_DEBUG("%s: operation %s on %s timed out",
+                       *this, operation, sock);
+            this->_record(udt::recorder::expiry, this->_queue(map), sock,
+                          operation);
+            if (wait)
+            {
+              wait->erase(sock);
+              this->_refresh(wait, sock);
+            }
+            ready.emplace_back(std::bind(work->second.cancel,
+                                         boost::asio::error::timed_out),
+                               std::move(work->second.invoker));
+            map.erase(work);
+          }
+        }
+
+        void
+        service::_untime(Operation operation)
+        {
+          if (this->_timeouts.erase(operation))
+            this->_deadlines.remove(operation);
+        }
+
+        void
+        service::_poll_drains(Ready& ready)
+        {
+          for (auto it = _drain_map.begin(); it != _drain_map.end();)
+          {
+            bool drained;
+            if (this->_offline)
+              drained = this->_drained.erase(it->first);
+            else
+            {
+              int pending = 0;
+              int size = sizeof(pending);
+              // An error means the connection is gone: let the action
+              // report it.
+              drained = UDT::getsockopt(it->first, 0, UDT_SNDDATA,
+                                        &pending, &size) == UDT::ERROR
+                || pending <= it->second.threshold;
             }
+            if (drained)
+            {
+              ELLE_DEBUG("%s: send buffer of %s drained", *this, it->first);
+              this->_record(udt::recorder::ready, udt::recorder::drain, it->first,
+                            it->second.operation);
+              this->_untime(it->second.operation);
+              ready.emplace_back(std::move(it->second.action),
+                                 std::move(it->second.invoker));
+              it = _drain_map.erase(it);
+            }
+            else
+              ++it;
           }
         }
 
         service::work::work(io_service& service,
-                            std::function<void ()> const& action,
-                            std::function<void ()> const& cancel)
-          : action(action)
+                            Operation operation,
+                            Action const& action,
+                            Cancel const& cancel,
+                            Invoker const& invoker)
+          : operation(operation)
+          , action(action)
           , cancel(cancel)
+          , invoker(invoker)
+          , threshold(0)
           , _work(service)
         {}
 
+        namespace
+        {
+          /// Action posted on behalf of a handler: forward the invoke hook
+          /// to the handler invoker.
+          struct invoked_action
+          {
+            service::Action action;
+            service::Invoker invoker;
+            /// When the operation became ready, if it did.
+            timing_wheel::Clock::time_point ready;
+
+            void
+            operator ()()
+            {
+              if (this->ready != timing_wheel::Clock::time_point() &&
+                  instrument::enabled())
+                instrument::dispatch_delay(
+                  timing_wheel::Clock::now() - this->ready);
+              this->action();
+            }
+
+            template <typename Function>
+            friend
+            void
+            asio_handler_invoke(Function& function, invoked_action* self)
+            {
+              if (self->invoker)
+                self->invoker(function);
+              else
+                function();
+            }
+
+            template <typename Function>
+            friend
+            void
+            asio_handler_invoke(Function const& function,
+                                invoked_action* self)
+            {
+              if (self->invoker)
+                self->invoker(function);
+              else
+                function();
+            }
+          };
+        }
+
+        void
+        service::_post(Action const& action, Invoker const& invoker,
+                       timing_wheel::Clock::time_point ready)
+        {
+          this->get_io_context().post(invoked_action{action, invoker, ready});
+        }
+
         void
         service::_wait_refresh(UDTSOCKET sock)
         {
@@ -170,6 +774,12 @@ namespace boost
             flags |= UDT_EPOLL_OUT;
             wait = true;
           }
+          this->_record(udt::recorder::refresh, udt::recorder::read, sock, 0,
+                        wait ? flags : 0);
+          if (this->_offline)
+            return;
+          if (this->_mode == shared)
+            dispatcher::instance().route(sock, false, wait ? this : nullptr);
           UDT::epoll_remove_usock(_epoll, sock);
           if (wait)
           {
@@ -181,66 +791,668 @@ namespace boost
         }
 
         void
-        service::register_read(socket* sock,
-                               std::function<void ()> const& action,
-                               std::function<void ()> const& cancel)
+        service::_sys_wait_refresh(SYSSOCKET fd)
         {
-          boost::unique_lock<boost::mutex> lock(_lock);
-          ELLE_TRACE_SCOPE("%s: register read action on %s", *this, *sock);
-          this->_wait_read.insert(sock->_udt_socket);
-          this->_wait_refresh(sock->_udt_socket);
-          this->_read_map.insert(std::make_pair
-                                 (sock->_udt_socket,
-                                  work(this->get_io_service(),
-                                       action, cancel)));
-          _barrier.notify_one();
+          int flags = 0;
+          if (this->_sys_wait_read.find(fd) != this->_sys_wait_read.end())
+            flags |= UDT_EPOLL_IN;
+          if (this->_sys_wait_write.find(fd) != this->_sys_wait_write.end())
+            flags |= UDT_EPOLL_OUT;
+          this->_record(udt::recorder::refresh, udt::recorder::system_read, fd, 0,
+                        flags);
+          if (this->_offline)
+            return;
+          if (this->_mode == shared)
+            dispatcher::instance().route(fd, true, flags ? this : nullptr);
+          // UDT epoll cannot update system fd events: register anew.
+          UDT::epoll_remove_ssock(_epoll, fd);
+          if (flags)
+          {
+            ELLE_DEBUG("%s: reregister fd %s", *this, fd);
+            UDT::epoll_add_ssock(_epoll, fd, &flags);
+          }
+          else
+            ELLE_DEBUG("%s: unregister fd %s", *this, fd);
         }
 
         void
-        service::cancel_read(socket* sock)
+        service::_refresh(std::set<int>* wait, int fd)
         {
-          boost::unique_lock<boost::mutex> lock(_lock);
-          ELLE_TRACE_SCOPE("%s: cancel read action on %s", *this, *sock);
-          this->_wait_read.erase(sock->_udt_socket);
-          this->_wait_refresh(sock->_udt_socket);
-          auto work = this->_read_map.find(sock->_udt_socket);
-          if (work != this->_read_map.end())
+          if (wait == &this->_sys_wait_read || wait == &this->_sys_wait_write)
+            this->_sys_wait_refresh(fd);
+          else
+            this->_wait_refresh(fd);
+        }
+
+        service::Operation
+        service::_register(Map& map, std::set<int>* wait, int fd,
+                           Action const& action, Cancel const& cancel,
+                           posix_time::time_duration const& timeout,
+                           Invoker const& invoker)
+        {
+          auto operation = ++this->_operation;
+          instrument::registration();
+          // A map holds one operation per fd: fail the newcomer rather than
+          // leaving it unanswered, or dropping the pending one.
+          if (map.find(fd) != map.end())
+          {
+            ELLE_WARN("%s: operation already pending on %s", *this, fd);
+            this->_post(std::bind(cancel, boost::asio::error::already_started),
+                        invoker);
+            return operation;
+          }
+          this->_start();
+          this->_record(udt::recorder::registration, this->_queue(map), fd,
+                        operation, timeout.is_special() ?
+                        -1 : timeout.total_milliseconds());
+          if (wait)
+          {
+            wait->insert(fd);
+            this->_refresh(wait, fd);
+          }
+          map.insert(std::make_pair(fd,
+                                    work(this->get_io_context(), operation,
+                                         action, cancel, invoker)));
+          if (!timeout.is_special())
+          {
+            auto deadline = this->_now() +
+              std::chrono::milliseconds(timeout.total_milliseconds());
+            this->_deadlines.add(operation, deadline);
+            this->_timeouts.insert(
+              std::make_pair(operation,
+                             Deadline{&map, wait, fd}));
+            if (deadline < this->_wait_deadline)
+              this->_wakeup();
+          }
+          return operation;
+        }
+
+        void
+        service::_cancel(Map& map, std::set<int>* wait,
+                         int fd, Operation operation)
+        {
+          Cancel cancel;
+          Invoker invoker;
+          {
+            auto lock = acquire(this->_lock);
+            this->_record(udt::recorder::cancellation, this->_queue(map), fd,
+                          operation);
+            auto work = map.find(fd);
+            if (work == map.end() ||
+                (operation != 0 && work->second.operation != operation))
+              return;
+            instrument::cancellation();
+            cancel = std::move(work->second.cancel);
+            invoker = std::move(work->second.invoker);
+            this->_untime(work->second.operation);
+            map.erase(work);
+            if (wait)
             {
-              work->second.cancel();
-              this->_read_map.erase(work);
+              wait->erase(fd);
+              this->_refresh(wait, fd);
             }
+            _barrier.notify_one();
+          }
+          // Never run user code under the reactor lock.
+          this->_post(std::bind(cancel, boost::asio::error::operation_aborted),
+                      invoker);
+        }
+
+        service::Operation
+        service::register_read(socket* sock,
+                               Action const& action,
+                               Cancel const& cancel,
+                               posix_time::time_duration const& timeout,
+                               Invoker const& invoker)
+        {
+          auto lock = acquire(this->_lock);
+          ELLE_TRACE_SCOPE("%s: register read action on %s", *this, *sock);
+          auto res = this->_register(this->_read_map, &this->_wait_read,
+                                     sock->_udt_socket, action, cancel,
+                                     timeout, invoker);
+          if (this->_read_map.find(sock->_udt_socket)->second.operation == res)
+            sock->_read_operation = res;
           _barrier.notify_one();
+          return res;
         }
 
         void
+        service::cancel_read(socket* sock, Operation operation)
+        {
+          ELLE_TRACE_SCOPE("%s: cancel read action on %s", *this, *sock);
+          this->_cancel(this->_read_map, &this->_wait_read,
+                        sock->_udt_socket, operation);
+        }
+
+        service::Operation
         service::register_write(socket* sock,
-                               std::function<void ()> const& action,
-                               std::function<void ()> const& cancel)
+                                Action const& action,
+                                Cancel const& cancel,
+                                posix_time::time_duration const& timeout,
+                                Invoker const& invoker)
         {
-          boost::unique_lock<boost::mutex> lock(_lock);
+          auto lock = acquire(this->_lock);
           ELLE_TRACE_SCOPE("%s: register write action on %s", *this, *sock);
-          this->_wait_write.insert(sock->_udt_socket);
-          this->_wait_refresh(sock->_udt_socket);
-          this->_write_map.insert(std::make_pair
-                                 (sock->_udt_socket,
-                                  work(this->get_io_service(),
-                                       action, cancel)));
+          auto res = this->_register(this->_write_map, &this->_wait_write,
+                                     sock->_udt_socket, action, cancel,
+                                     timeout, invoker);
+          if (this->_write_map.find(sock->_udt_socket)->second.operation ==
+              res)
+            sock->_write_operation = res;
           _barrier.notify_one();
+          return res;
         }
 
         void
-        service::cancel_write(socket* sock)
+        service::cancel_write(socket* sock, Operation operation)
         {
-          boost::unique_lock<boost::mutex> lock(_lock);
           ELLE_TRACE_SCOPE("%s: cancel write action on %s", *this, *sock);
-          this->_wait_write.erase(sock->_udt_socket);
-          this->_wait_refresh(sock->_udt_socket);
-          auto work = this->_write_map.find(sock->_udt_socket);
-          if (work != this->_write_map.end())
+          this->_cancel(this->_write_map, &this->_wait_write,
+                        sock->_udt_socket, operation);
+        }
+
+        service::Operation
+        service::register_drain(socket* sock,
+                                Action const& action,
+                                Cancel const& cancel,
+                                Invoker const& invoker,
+                                int threshold)
+        {
+          auto lock = acquire(this->_lock);
+          ELLE_TRACE_SCOPE("%s: register drain action on %s", *this, *sock);
+          auto res = this->_register(this->_drain_map, nullptr,
+                                     sock->_udt_socket, action, cancel,
+                                     posix_time::pos_infin, invoker);
+          auto work = this->_drain_map.find(sock->_udt_socket);
+          if (work->second.operation == res)
+            work->second.threshold = threshold;
+          _barrier.notify_one();
+          // The reactor may be blocked without timeout.
+          this->_wakeup();
+          return res;
+        }
+
+        void
+        service::cancel_drain(socket* sock, Operation operation)
+        {
+          ELLE_TRACE_SCOPE("%s: cancel drain action on %s", *this, *sock);
+          this->_cancel(this->_drain_map, nullptr, sock->_udt_socket,
+                        operation);
+        }
+
+        service::Operation
+        service::register_system_read(SYSSOCKET fd,
+                                      Action const& action,
+                                      Cancel const& cancel,
+                                      posix_time::time_duration const& timeout,
+                                      Invoker const& invoker)
+        {
+          auto lock = acquire(this->_lock);
+          ELLE_TRACE_SCOPE("%s: register read action on fd %s", *this, fd);
+          auto res = this->_register(this->_sys_read_map,
+                                     &this->_sys_wait_read, fd,
+                                     action, cancel, timeout, invoker);
+          _barrier.notify_one();
+          return res;
+        }
+
+        void
+        service::cancel_system_read(SYSSOCKET fd, Operation operation)
+        {
+          ELLE_TRACE_SCOPE("%s: cancel read action on fd %s", *this, fd);
+          this->_cancel(this->_sys_read_map, &this->_sys_wait_read,
+                        fd, operation);
+        }
+
+        service::Operation
+        service::register_system_write(SYSSOCKET fd,
+                                       Action const& action,
+                                       Cancel const& cancel,
+                                       posix_time::time_duration const& timeout,
+                                       Invoker const& invoker)
+        {
+          auto lock = acquire(this->_lock);
+          ELLE_TRACE_SCOPE("%s: register write action on fd %s", *this, fd);
+          auto res = this->_register(this->_sys_write_map,
+                                     &this->_sys_wait_write, fd,
+                                     action, cancel, timeout, invoker);
+          _barrier.notify_one();
+          return res;
+        }
+
+        void
+        service::cancel_system_write(SYSSOCKET fd, Operation operation)
+        {
+          ELLE_TRACE_SCOPE("%s: cancel write action on fd %s", *this, fd);
+          this->_cancel(this->_sys_write_map, &this->_sys_wait_write,
+                        fd, operation);
+        }
+
+        void
+        service::reap(UDTSOCKET sock)
+        {
+          boost::unique_lock<boost::mutex> lock(_reap_lock);
+          ELLE_TRACE_SCOPE("%s: schedule %s for closing", *this, sock);
+          // The reaper is gone with the service, close in place.
+          if (this->_stop)
+          {
+            lock.unlock();
+            if (UDT::close(sock) == UDT::ERROR)
+              ELLE_WARN("%s: unable to close %s: %s",
+                        *this, sock, UDT::getlasterror().getErrorMessage());
+            return;
+          }
+          this->_reap_queue.push_back(sock);
+          // Start the reaper on demand, most services never need it.
+          if (!this->_reaper)
+            this->_reaper.reset(
+              new boost::thread(std::bind(&service::_reap, this)));
+          _reap_barrier.notify_one();
+        }
+
+        void
+        service::_reap()
+        {
+          boost::unique_lock<boost::mutex> lock(_reap_lock);
+          while (true)
+          {
+            // Close everything still queued before stopping, so no UDT
+            // socket is leaked.
+            while (this->_reap_queue.empty())
+            {
+              if (_stop)
+                return;
+              _reap_barrier.wait(lock);
+            }
+            auto sock = this->_reap_queue.front();
+            this->_reap_queue.pop_front();
+            lock.unlock();
+            ELLE_DEBUG("%s: close %s", *this, sock);
+            // May linger until the send buffer is flushed.
+            if (UDT::close(sock) == UDT::ERROR)
+              ELLE_WARN("%s: unable to close %s: %s",
+                        *this, sock, UDT::getlasterror().getErrorMessage());
+            lock.lock();
+          }
+        }
+
+        buffer_pool&
+        service::buffers()
+        {
+          return this->_buffers;
+        }
+
+        void
+        service::buffers(std::size_t slab_size, std::size_t count)
+        {
+          ELLE_TRACE("%s: provide %s slabs of %s bytes",
+                     *this, count, slab_size);
+          this->_buffers = buffer_pool(slab_size, count);
+        }
+
+        void
+        service::bandwidth(std::int64_t budget)
+        {
+          auto lock = acquire(this->_lock);
+          ELLE_TRACE("%s: set bandwidth budget to %s", *this, budget);
+          this->_bandwidth = budget;
+          if (budget < 0)
+          {
+            for (auto& flow: this->_flows)
+              flow.second.active = false;
+            this->_active_flows = 0;
+          }
+          this->_rebalance();
+        }
+
+        void
+        service::busy_poll(std::chrono::microseconds budget)
+        {
+          ELLE_TRACE("%s: busy poll for %sus", *this, budget.count());
+          this->_busy_poll = budget.count();
+          this->_wakeup();
+        }
+
+        std::chrono::microseconds
+        service::busy_poll() const
+        {
+          return std::chrono::microseconds(this->_busy_poll);
+        }
+
+        void
+        service::affinity(int cpu)
+        {
+          this->_cpu = cpu;
+          // Let the reactor pin itself.
+          this->_wakeup();
+        }
+
+        int
+        service::affinity() const
+        {
+          return this->_cpu;
+        }
+
+        void
+        service::udt_affinity(int cpu)
+        {
+          this->_udt_cpu = cpu;
+        }
+
+        int
+        service::udt_affinity() const
+        {
+          return this->_udt_cpu;
+        }
+
+        void
+        service::recorder(std::shared_ptr<udt::recorder> const& recorder)
+        {
+          auto lock = acquire(this->_lock);
+          std::atomic_store(&this->_recorder, recorder);
+        }
+
+        std::shared_ptr<udt::recorder>
+        service::recorder() const
+        {
+          return std::atomic_load(&this->_recorder);
+        }
+
+        void
+        service::_record(udt::recorder::kind kind, udt::recorder::queue queue,
+                         int fd, Operation operation, int value)
+        {
+          if (this->_recorder)
+            this->_recorder->record(kind, queue, fd, operation, value);
+        }
+
+        void
+        service::_record(std::set<int> const& fds, udt::recorder::queue queue)
+        {
+          for (auto fd: fds)
+            this->_recorder->record(udt::recorder::ready, queue, fd);
+        }
+
+        udt::recorder::queue
+        service::_queue(Map const& map) const
+        {
+          if (&map == &this->_write_map)
+            return udt::recorder::write;
+          else if (&map == &this->_drain_map)
+            return udt::recorder::drain;
+          else if (&map == &this->_sys_read_map)
+            return udt::recorder::system_read;
+          else if (&map == &this->_sys_write_map)
+            return udt::recorder::system_write;
+          return udt::recorder::read;
+        }
+
+        void
+        service::batch(std::size_t size)
+        {
+          this->_batch = size;
+        }
+
+        std::size_t
+        service::batch() const
+        {
+          return this->_batch;
+        }
+
+        void
+        service::autotune(std::size_t memory)
+        {
+          ELLE_TRACE("%s: autotune buffers within %s bytes", *this, memory);
+          this->_autotune = memory;
+        }
+
+        std::size_t
+        service::autotune() const
+        {
+          return this->_autotune;
+        }
+
+        std::size_t
+        service::_tune(UDTSOCKET sock, ip::address const* peer, bool charge)
+        {
+          std::size_t memory = this->_autotune;
+          if (!memory)
+            return 0;
+          boost::mutex::scoped_lock lock(this->_autotune_lock);
+          std::size_t size = autotune_default;
+          if (peer)
+          {
+            auto it = this->_estimates.find(*peer);
+            if (it != this->_estimates.end())
+            {
+              this->_estimates_lru.splice(this->_estimates_lru.begin(),
+                                          this->_estimates_lru,
+                                          it->second.use);
+              // Twice the bandwidth-delay product, to keep the pipe full
+              // while losses are recovered.
+              double bdp = it->second.rtt / 1000 *
+                it->second.bandwidth * 1000000 / 8;
+              size = static_cast<std::size_t>(
+                std::min(std::max(2 * bdp, double(autotune_min)),
+                         double(autotune_max)));
+            }
+          }
+          // Send and receive buffers both count. Past the budget, keep UDT
+          // defaults rather than granting more.
+          std::size_t available =
+            memory > this->_autotuned ? memory - this->_autotuned : 0;
+          if (available < 2 * autotune_min)
+          {
+            ELLE_DEBUG("%s: autotune budget exhausted, leave %s untuned",
+                       *this, sock);
+            return 0;
+          }
+          size = std::max(std::min(size, available / 2), autotune_min);
+          // The receive buffer may not exceed the flow window, in packets.
+          int window = std::max<int>(size / 1500, 32);
+          int bytes = size;
+          if (UDT::setsockopt(sock, 0, UDT_FC, &window, sizeof(window)) ==
+                UDT::ERROR ||
+              UDT::setsockopt(sock, 0, UDT_SNDBUF, &bytes, sizeof(bytes)) ==
+                UDT::ERROR ||
+              UDT::setsockopt(sock, 0, UDT_RCVBUF, &bytes, sizeof(bytes)) ==
+                UDT::ERROR)
+          {
+            // Typically because the socket is already bound.
+            ELLE_DEBUG("%s: unable to tune %s: %s", *this, sock,
+                       UDT::getlasterror().getErrorMessage());
+            return 0;
+          }
+          ELLE_DEBUG("%s: tune %s buffers to %s bytes", *this, sock, size);
+          if (charge)
+            this->_autotuned += 2 * size;
+          return 2 * size;
+        }
+
+        std::size_t
+        service::autotuned() const
+        {
+          boost::mutex::scoped_lock lock(this->_autotune_lock);
+          return this->_autotuned;
+        }
+
+        std::size_t
+        service::_grant(std::size_t size)
+        {
+          boost::mutex::scoped_lock lock(this->_autotune_lock);
+          if (this->_autotuned + size > this->_autotune)
+          {
+            ELLE_DEBUG("%s: autotune budget exhausted, grant nothing", *this);
+            return 0;
+          }
+          this->_autotuned += size;
+          return size;
+        }
+
+        void
+        service::_untune(UDTSOCKET sock, ip::address const& peer,
+                         std::size_t granted)
+        {
+          if (!granted && !this->_autotune)
+            return;
+          UDT::TRACEINFO perf;
+          bool measured = this->_autotune &&
+            UDT::perfmon(sock, &perf, false) != UDT::ERROR &&
+            perf.msRTT > 0 && perf.mbpsBandwidth > 0;
+          boost::mutex::scoped_lock lock(this->_autotune_lock);
+          this->_autotuned -= std::min(granted, this->_autotuned);
+          if (!measured)
+            return;
+          ELLE_DEBUG("%s: %s measured %sms RTT and %sMb/s to %s",
+                     *this, sock, perf.msRTT, perf.mbpsBandwidth, peer);
+          auto it = this->_estimates.find(peer);
+          if (it == this->_estimates.end())
+          {
+            if (this->_estimates.size() >= autotune_peers)
             {
-              work->second.cancel();
-              this->_write_map.erase(work);
+              this->_estimates.erase(this->_estimates_lru.back());
+              this->_estimates_lru.pop_back();
             }
+            this->_estimates_lru.push_front(peer);
+            this->_estimates.insert(
+              std::make_pair(peer, Estimate{perf.msRTT, perf.mbpsBandwidth,
+                                            this->_estimates_lru.begin()}));
+          }
+          else
+          {
+            this->_estimates_lru.splice(this->_estimates_lru.begin(),
+                                        this->_estimates_lru, it->second.use);
+            // Smooth out unlucky connections.
+            it->second.rtt = (it->second.rtt + perf.msRTT) / 2;
+            it->second.bandwidth =
+              (it->second.bandwidth + perf.mbpsBandwidth) / 2;
+          }
+        }
+
+        std::int64_t
+        service::bandwidth() const
+        {
+          return this->_bandwidth;
+        }
+
+        void
+        service::weight(socket* sock, unsigned weight)
+        {
+          auto lock = acquire(this->_lock);
+          auto& flow = this->_flow(sock->_udt_socket);
+          flow.weight = std::max(weight, 1u);
+          if (flow.active)
+            this->_rebalance();
+        }
+
+        service::Flow&
+        service::_flow(UDTSOCKET sock)
+        {
+          return this->_flows.insert(
+            std::make_pair(sock, Flow{1, false, -1})).first->second;
+        }
+
+        void
+        service::_sending(socket* sock)
+        {
+          // Keep the common, unbudgeted, path lock free.
+          if (this->_bandwidth < 0)
+            return;
+          auto lock = acquire(this->_lock);
+          auto& flow = this->_flow(sock->_udt_socket);
+          if (flow.active || this->_bandwidth < 0)
+            return;
+          ELLE_DEBUG("%s: %s starts sending", *this, sock->_udt_socket);
+          flow.active = true;
+          if (this->_active_flows++ == 0)
+          {
+            this->_deadlines.remove(schedule_key);
+            this->_deadlines.add(
+              schedule_key, this->_now() +
+              std::chrono::milliseconds(schedule_interval));
+            // Sockets may send without ever waiting: the reactor must run
+            // for the timer to expire.
+            this->_start();
+            this->_barrier.notify_one();
+            this->_wakeup();
+          }
+          this->_rebalance();
+        }
+
+        void
+        service::_unschedule(UDTSOCKET sock)
+        {
+          auto lock = acquire(this->_lock);
+          auto it = this->_flows.find(sock);
+          if (it == this->_flows.end())
+            return;
+          bool active = it->second.active;
+          this->_flows.erase(it);
+          if (active)
+          {
+            --this->_active_flows;
+            this->_rebalance();
+          }
+        }
+
+        void
+        service::_schedule()
+        {
+          if (!this->_active_flows)
+            return;
+          bool changed = false;
+          for (auto& flow: this->_flows)
+          {
+            if (!flow.second.active ||
+                this->_write_map.find(flow.first) != this->_write_map.end())
+              continue;
+            int pending = 0;
+            int size = sizeof(pending);
+            if (UDT::getsockopt(flow.first, 0, UDT_SNDDATA,
+                                &pending, &size) != UDT::ERROR &&
+                pending > 0)
+              continue;
+            ELLE_DEBUG("%s: %s stopped sending", *this, flow.first);
+            flow.second.active = false;
+            --this->_active_flows;
+            changed = true;
+          }
+          if (changed)
+            this->_rebalance();
+          if (this->_active_flows)
+            this->_deadlines.add(
+              schedule_key, this->_now() +
+              std::chrono::milliseconds(schedule_interval));
+        }
+
+        void
+        service::_rebalance()
+        {
+          std::int64_t budget = this->_bandwidth;
+          std::uint64_t weights = 0;
+          for (auto const& flow: this->_flows)
+            if (flow.second.active)
+              weights += flow.second.weight;
+          for (auto& flow: this->_flows)
+          {
+            std::int64_t cap = -1;
+            if (budget >= 0 && flow.second.active)
+              cap = std::max<std::int64_t>(
+                budget * flow.second.weight / weights, 1);
+            // Idle flows keep their cap until they send again.
+            else if (budget >= 0)
+              continue;
+            if (cap == flow.second.cap)
+              continue;
+            ELLE_DEBUG("%s: cap %s to %s bytes per second",
+                       *this, flow.first, cap);
+            if (UDT::setsockopt(flow.first, 0, UDT_MAXBW,
+                                &cap, sizeof(cap)) == UDT::ERROR)
+              ELLE_WARN("%s: unable to cap %s: %s", *this, flow.first,
+                        UDT::getlasterror().getErrorMessage());
+            else
+              flow.second.cap = cap;
+          }
         }
       }
     }
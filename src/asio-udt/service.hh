@@ -1,15 +1,24 @@
 #ifndef ASIO_UDT_SERVICE_HH
 # define ASIO_UDT_SERVICE_HH
 
+# include <atomic>
+# include <cstdint>
+# include <deque>
 # include <functional>
+# include <list>
+# include <map>
 # include <unordered_map>
+# include <utility>
 
 # include <boost/asio.hpp>
 # include <boost/thread.hpp>
 
 # include <udt/udt.h>
 
+# include <asio-udt/buffer-pool.hh>
 # include <asio-udt/fwd.hh>
+# include <asio-udt/recorder.hh>
+# include <asio-udt/timing-wheel.hh>
 
 namespace boost
 {
@@ -22,7 +31,24 @@ namespace boost
         class service: public io_service::service
         {
         public:
-          service(io_service& io_service);
+          /// How readiness is waited upon.
+          enum mode
+          {
+            /// A dedicated reactor thread blocks on the UDT epoll and posts
+            /// ready actions to the io_service.
+            threaded,
+            /// No reactor thread: while operations are pending, a handler
+            /// reposting itself polls the UDT epoll without blocking from
+            /// the io_service threads and runs ready actions in place. Once
+            /// a poll finds nothing ready, the next one waits a millisecond.
+            polled,
+            /// Like threaded, but with a single reactor thread and UDT epoll
+            /// shared by all services of the process in this mode.
+            shared,
+          };
+
+        public:
+          service(io_service& io_service, mode mode = threaded);
           ~service();
 
             static io_service::id id;
@@ -30,53 +56,419 @@ namespace boost
             virtual
             void
             shutdown_service();
-            void
+            /// Action run once the operation can be performed.
+            typedef std::function<void ()> Action;
+            /// Completion of an aborted operation.
+            typedef std::function<void (system::error_code const&)> Cancel;
+            /// Identifier of a registered operation, never 0.
+            typedef std::uint64_t Operation;
+            /// Run an action or cancel completion on behalf of the operation
+            /// handler.
+            typedef std::function<void (Action const&)> Invoker;
+            /// Invoker honoring the associated executor and
+            /// asio_handler_invoke hook of handler, so completions of
+            /// handlers bound to a strand run straight on it. The handler
+            /// is shared with the action and cancel completion, so it may
+            /// be move-only.
+            template <typename Handler>
+            static
+            Invoker
+            invoker(io_service& io_service,
+                    std::shared_ptr<Handler> const& handler);
+
+            /// Run action once sock is readable. If timeout is not infinite
+            /// and elapses first, cancel is posted with timed_out. A socket
+            /// has at most one pending operation per kind: if there is one
+            /// already, cancel is posted with already_started.
+            Operation
             register_read(socket* sock,
-                          std::function<void ()> const& action,
-                          std::function<void ()> const& cancel);
-            void
-            cancel_read(socket* sock);
+                          Action const& action,
+                          Cancel const& cancel,
+                          posix_time::time_duration const& timeout =
+                            posix_time::pos_infin,
+                          Invoker const& invoker = Invoker());
+            /// Cancel the read operation on sock, or only operation if
+            /// non-zero. The cancel completion is posted with
+            /// operation_aborted.
             void
+            cancel_read(socket* sock, Operation operation = 0);
+            Operation
             register_write(socket* sock,
-                           std::function<void ()> const& action,
-                           std::function<void ()> const& cancel);
+                           Action const& action,
+                           Cancel const& cancel,
+                           posix_time::time_duration const& timeout =
+                             posix_time::pos_infin,
+                           Invoker const& invoker = Invoker());
+            void
+            cancel_write(socket* sock, Operation operation = 0);
+            /// Run action once the send buffer of sock holds at most
+            /// threshold packets, by default once it is empty.
+            Operation
+            register_drain(socket* sock,
+                           Action const& action,
+                           Cancel const& cancel,
+                           Invoker const& invoker = Invoker(),
+                           int threshold = 0);
+            void
+            cancel_drain(socket* sock, Operation operation = 0);
+            /// Run action once the system file descriptor fd, a pipe or a
+            /// kernel socket, is readable. It is waited upon by the same
+            /// reactor as UDT sockets, so relaying between fd and a UDT
+            /// socket takes no extra thread handoff. The service neither
+            /// owns nor closes fd: cancel pending operations first.
+            Operation
+            register_system_read(SYSSOCKET fd,
+                                 Action const& action,
+                                 Cancel const& cancel,
+                                 posix_time::time_duration const& timeout =
+                                   posix_time::pos_infin,
+                                 Invoker const& invoker = Invoker());
+            void
+            cancel_system_read(SYSSOCKET fd, Operation operation = 0);
+            Operation
+            register_system_write(SYSSOCKET fd,
+                                  Action const& action,
+                                  Cancel const& cancel,
+                                  posix_time::time_duration const& timeout =
+                                    posix_time::pos_infin,
+                                  Invoker const& invoker = Invoker());
+            void
+            cancel_system_write(SYSSOCKET fd, Operation operation = 0);
+            /// Wait until fd is ready for type, asio style.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code))
+            async_wait(SYSSOCKET fd, socket_base::wait_type type,
+                       Handler&& handler);
+            /// Close sock in the background, without blocking the caller on
+            /// UDT lingering.
+            void
+            reap(UDTSOCKET sock);
+            /// Slabs provided to socket::async_receive.
+            buffer_pool&
+            buffers();
+            /// Replace the slab pool, before any async_receive is issued.
+            /// Slabs of the previous pool still in use remain valid.
+            void
+            buffers(std::size_t slab_size, std::size_t count);
+            /// Total egress budget of the sockets of this service, in bytes
+            /// per second. It is shared among the sockets currently sending
+            /// in proportion to their weight, by adjusting their UDT_MAXBW.
+            /// Negative for no budget, the default.
+            void
+            bandwidth(std::int64_t budget);
+            std::int64_t
+            bandwidth() const;
+            /// Relative share of sock in the bandwidth budget, 1 by default.
+            void
+            weight(socket* sock, unsigned weight);
+            /// Post the actions made ready by one reactor wakeup in chunks
+            /// of at most size actions, one handler per chunk, instead of
+            /// one handler per action. Chunks are spread across the
+            /// io_service threads. 0, the default, disables batching.
+            void
+            batch(std::size_t size);
+            std::size_t
+            batch() const;
+            /// Size the buffers and flow window of new connections after the
+            /// bandwidth-delay product measured when closing previous
+            /// connections to the same peer. At most memory bytes of UDT
+            /// buffers are granted to all tuned connections together: once
+            /// exhausted, new connections keep UDT defaults, and accepted
+            /// ones the listener buffers, uncharged. 0, the default, keeps
+            /// UDT defaults.
+            void
+            autotune(std::size_t memory);
+            std::size_t
+            autotune() const;
+            /// Buffer bytes currently granted to tuned connections.
+            std::size_t
+            autotuned() const;
+            /// Before blocking on the UDT epoll, spin on it with a zero
+            /// timeout for budget: events arriving meanwhile are picked up
+            /// without UDT and kernel wakeups, at the cost of a busy core.
+            /// Threaded mode only. Zero, the default, always blocks.
             void
-            cancel_write(socket* sock);
+            busy_poll(std::chrono::microseconds budget);
+            std::chrono::microseconds
+            busy_poll() const;
+            /// Pin the reactor thread to cpu, negative for none, the
+            /// default. Threaded mode only.
+            void
+            affinity(int cpu);
+            int
+            affinity() const;
+            /// Pin the UDT threads started on behalf of the sockets of this
+            /// service to cpu, negative for none, the default. UDT starts a
+            /// send and a receive thread whenever a socket binds or
+            /// connects from a new port; they inherit the pinning.
+            void
+            udt_affinity(int cpu);
+            int
+            udt_affinity() const;
+            /// Record registrations, cancellations, epoll results and
+            /// timeouts to recorder, for offline replay. Null, the default,
+            /// records nothing.
+            void
+            recorder(std::shared_ptr<udt::recorder> const& recorder);
+            std::shared_ptr<udt::recorder>
+            recorder() const;
         private:
           std::set<UDTSOCKET> _wait_read;
           std::set<UDTSOCKET> _wait_write;
           void
           _wait_refresh(UDTSOCKET sock);
+          std::set<SYSSOCKET> _sys_wait_read;
+          std::set<SYSSOCKET> _sys_wait_write;
+          void
+          _sys_wait_refresh(SYSSOCKET fd);
+          /// Refresh the epoll registration of fd after wait changed.
+          void
+          _refresh(std::set<int>* wait, int fd);
+          /// async_initiate initiation.
+          struct _initiate_system_wait;
+          mode _mode;
+          Operation _operation;
 
           private:
             int _epoll;
+            /// Self-pipe to wake the reactor up when its timeout changes.
+            int _interrupt[2];
+            void
+            _wakeup();
 
+            /// Reactor thread, started on the first registration.
             std::unique_ptr<boost::thread> _thread;
             void
             _run();
+            std::atomic<std::int64_t> _busy_poll;
+            std::atomic<int> _cpu;
+            std::atomic<int> _udt_cpu;
+            /// Poll the UDT epoll without blocking until events are ready,
+            /// for at most budget and timeout milliseconds if not negative.
+            bool
+            _spin(std::set<UDTSOCKET>& readfds,
+                  std::set<UDTSOCKET>& writefds,
+                  std::set<SYSSOCKET>& sysfds,
+                  std::set<SYSSOCKET>& syswritefds,
+                  std::chrono::microseconds budget,
+                  int timeout);
+            /// Non-blocking reactor iteration for the polled mode.
+            void
+            _poll();
+            /// Start the reactor if it does not run yet, under the lock.
+            void
+            _start();
+            typedef std::vector<std::pair<Action, Invoker>> Ready;
+            friend class dispatcher;
+            /// Process a reactor wakeup at now, and post ready actions.
+            void
+            _dispatch(std::set<UDTSOCKET> const& readfds,
+                      std::set<UDTSOCKET> const& writefds,
+                      std::set<SYSSOCKET> const& sysfds,
+                      std::set<SYSSOCKET> const& syswritefds,
+                      timing_wheel::Clock::time_point now);
+            /// Collect the actions ready after a wait.
+            void
+            _process(std::set<UDTSOCKET> const& readfds,
+                     std::set<UDTSOCKET> const& writefds,
+                     std::set<SYSSOCKET> const& sysfds,
+                     std::set<SYSSOCKET> const& syswritefds,
+                     Ready& ready);
+            void
+            _poll_drains(Ready& ready);
+            /// Set under the lock, read under the lock by the reactor.
+            std::shared_ptr<udt::recorder> _recorder;
+            void
+            _record(udt::recorder::kind kind, udt::recorder::queue queue,
+                    int fd, Operation operation = 0, int value = 0);
+            /// Recorded events for all ready fds of a wakeup.
+            void
+            _record(std::set<int> const& fds, udt::recorder::queue queue);
+            friend class replay;
+            /// Replaying: sockets are not polled, drains complete as
+            /// recorded in _drained and time is that of the trace.
+            bool _offline;
+            timing_wheel::Clock::time_point _replayed;
+            /// The time deadlines are measured against.
+            timing_wheel::Clock::time_point
+            _now() const;
+            std::set<UDTSOCKET> _drained;
 
             class work
             {
               public:
                 work(io_service& service,
-                     std::function<void ()> const& action,
-                     std::function<void ()> const& cancel);
-                std::function<void ()> action;
-                std::function<void ()> cancel;
+                     Operation operation,
+                     Action const& action,
+                     Cancel const& cancel,
+                     Invoker const& invoker);
+                Operation operation;
+                Action action;
+                Cancel cancel;
+                Invoker invoker;
+                /// Packets left in the send buffer below which a drain
+                /// action is ready.
+                int threshold;
               private:
                 io_service::work _work;
             };
 
+            /// Operations by UDT socket or system file descriptor.
             typedef std::unordered_map<int, work> Map;
+            udt::recorder::queue
+            _queue(Map const& map) const;
+            Operation
+            _register(Map& map, std::set<int>* wait, int fd,
+                      Action const& action, Cancel const& cancel,
+                      posix_time::time_duration const& timeout,
+                      Invoker const& invoker);
+            /// Post action to the io_service through invoker. Ready is when
+            /// the operation became ready, to measure the dispatch delay.
+            void
+            _post(Action const& action, Invoker const& invoker,
+                  timing_wheel::Clock::time_point ready =
+                    timing_wheel::Clock::time_point());
+            void
+            _cancel(Map& map, std::set<int>* wait,
+                    int fd, Operation operation);
             Map _read_map;
             Map _write_map;
+            Map _drain_map;
+            Map _sys_read_map;
+            Map _sys_write_map;
             boost::mutex _lock;
             boost::condition_variable _barrier;
             bool _stop;
+            /// Whether a poll is scheduled, in polled mode.
+            bool _polling;
+            /// Polls finding nothing ready wait on the timer before the
+            /// next one, under the lock.
+            boost::asio::steady_timer _poll_timer;
+            bool _poll_idle;
+            /// Fail all pending operations with error, the reactor being
+            /// unable to wait on them.
+            void
+            _fail(system::error_code const& error);
+            std::atomic<std::size_t> _batch;
+            /// Run ready actions [begin, end).
+            void
+            _run_ready(std::shared_ptr<Ready> const& ready,
+                       std::size_t begin, std::size_t end,
+                       timing_wheel::Clock::time_point ready_at);
+
+          private:
+            std::unique_ptr<boost::thread> _reaper;
+            void
+            _reap();
+            std::deque<UDTSOCKET> _reap_queue;
+            boost::mutex _reap_lock;
+            boost::condition_variable _reap_barrier;
+
+          private:
+            buffer_pool _buffers;
+
+          private:
+            friend class broadcast;
+            /// Keep object alive until released, or until the service shuts
+            /// down: its pending operations never complete then.
+            void
+            _retain(std::shared_ptr<void> object);
+            /// Stop keeping object alive, returning the last reference.
+            std::shared_ptr<void>
+            _release(void* object);
+            std::unordered_map<void*, std::shared_ptr<void>> _retained;
+            boost::mutex _retained_lock;
+
+          private:
+            friend class acceptor;
+            friend class socket;
+            /// A transfer on sock starts or goes on.
+            void
+            _sending(socket* sock);
+            /// Sock is closed.
+            void
+            _unschedule(UDTSOCKET sock);
+            struct Flow
+            {
+              unsigned weight;
+              /// Whether the socket is sending.
+              bool active;
+              /// UDT_MAXBW currently set.
+              std::int64_t cap;
+            };
+            std::atomic<std::int64_t> _bandwidth;
+            std::unordered_map<UDTSOCKET, Flow> _flows;
+            unsigned _active_flows;
+            Flow&
+            _flow(UDTSOCKET sock);
+            /// Retire flows that stopped sending. Run by the reactor when
+            /// the schedule timer of the deadline wheel expires, armed
+            /// while flows are active.
+            void
+            _schedule();
+            /// Share the budget among active flows.
+            void
+            _rebalance();
+
+          private:
+            /// Measures of the path to a peer.
+            struct Estimate
+            {
+              /// Round trip time, in milliseconds.
+              double rtt;
+              /// Link capacity, in megabits per second.
+              double bandwidth;
+              /// Position in _estimates_lru.
+              std::list<ip::address>::iterator use;
+            };
+            std::atomic<std::size_t> _autotune;
+            /// Buffer bytes granted to tuned connections.
+            std::size_t _autotuned;
+            std::map<ip::address, Estimate> _estimates;
+            /// Peers with estimates, most recently used first: the least
+            /// recently used is forgotten first.
+            std::list<ip::address> _estimates_lru;
+            mutable boost::mutex _autotune_lock;
+            /// Size the buffers of unopened sock after the estimates for
+            /// peer, or for an unknown peer if null. The granted size is
+            /// returned and accounted for if charge, 0 if untuned.
+            std::size_t
+            _tune(UDTSOCKET sock, ip::address const* peer, bool charge);
+            /// Account for a connection with granted buffers.
+            std::size_t
+            _grant(std::size_t size);
+            /// Record the estimates measured by sock to peer and release its
+            /// granted buffers.
+            void
+            _untune(UDTSOCKET sock, ip::address const& peer,
+                    std::size_t granted);
+
+          private:
+            /// Operation timeouts.
+            struct Deadline
+            {
+              Map* map;
+              std::set<int>* wait;
+              int socket;
+            };
+            timing_wheel _deadlines;
+            std::unordered_map<Operation, Deadline> _timeouts;
+            /// When the reactor will wake up by itself.
+            timing_wheel::Clock::time_point _wait_deadline;
+            /// Epoll timeout until the next deadline, in milliseconds.
+            int
+            _timeout();
+            void
+            _expire(Ready& ready);
+            void
+            _untime(Operation operation);
         };
       }
     }
   }
 }
 
+# include <asio-udt/service.hxx>
+
 #endif
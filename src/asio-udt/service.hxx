@@ -0,0 +1,109 @@
+#ifndef ASIO_UDT_SERVICE_HXX
+# define ASIO_UDT_SERVICE_HXX
+
+# include <memory>
+
+# include <boost/asio/detail/handler_invoke_helpers.hpp>
+# include <boost/asio/dispatch.hpp>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        template <typename Handler>
+        class handler_invoker
+        {
+          public:
+            handler_invoker(io_service& io_service,
+                            std::shared_ptr<Handler> const& handler)
+              : _handler(handler)
+              , _executor(get_associated_executor(*handler,
+                                                  io_service.get_executor()))
+            {}
+
+            void
+            operator ()(service::Action const& action)
+            {
+              // Dispatching onto the io_service executor from one of its
+              // threads runs inline.
+              asio::dispatch(this->_executor,
+                             invocation{action, this->_handler});
+            }
+
+          private:
+            struct invocation
+            {
+              service::Action action;
+              std::shared_ptr<Handler> handler;
+
+              void
+              operator ()()
+              {
+                boost_asio_handler_invoke_helpers::invoke(this->action,
+                                                          *this->handler);
+              }
+            };
+
+            std::shared_ptr<Handler> _handler;
+            typename associated_executor<
+              Handler, io_service::executor_type>::type _executor;
+        };
+
+        template <typename Handler>
+        service::Invoker
+        service::invoker(io_service& io_service,
+                         std::shared_ptr<Handler> const& handler)
+        {
+          return handler_invoker<Handler>(io_service, handler);
+        }
+
+        struct service::_initiate_system_wait
+        {
+          service* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler, SYSSOCKET fd,
+                      socket_base::wait_type type) const
+          {
+            typedef typename std::decay<Handler>::type Completion;
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            auto action = [h] ()
+              {
+                (*h)(system::error_code());
+              };
+            auto cancel = [h] (system::error_code const& error)
+              {
+                (*h)(error);
+              };
+            auto& io_service = this->self->get_io_context();
+            if (type == socket_base::wait_write)
+              this->self->register_system_write
+                (fd, action, cancel, posix_time::pos_infin,
+                 service::invoker(io_service, h));
+            else
+              this->self->register_system_read
+                (fd, action, cancel, posix_time::pos_infin,
+                 service::invoker(io_service, h));
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler, void (system::error_code))
+        service::async_wait(SYSSOCKET fd, socket_base::wait_type type,
+                            Handler&& handler)
+        {
+          return async_initiate<Handler, void (system::error_code)>(
+            _initiate_system_wait{this}, handler, fd, type);
+        }
+      }
+    }
+  }
+}
+
+#endif
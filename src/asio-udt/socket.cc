@@ -1,5 +1,10 @@
+#include <algorithm>
+
+#include <boost/asio/detail/throw_error.hpp>
+#include <boost/assert.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <asio-udt/affinity.hh>
 #include <asio-udt/error-category.hh>
 #include <asio-udt/service.hh>
 #include <asio-udt/socket.hh>
@@ -32,13 +37,129 @@ namespace boost
           : socket(io_service, UDT::socket(AF_INET, SOCK_STREAM, 0),
                    endpoint_type())
         {
-          this->set_option(non_blocking{true});
+          system::error_code error;
+          this->_setup(error);
+          asio::detail::throw_error(error, "socket");
+        }
+
+        socket::socket(socket&& source)
+          : _service(source._service)
+          , _udt_service(source._udt_service)
+          , _udt_socket(source._udt_socket)
+          , _ready_read(source._ready_read)
+          , _ready_write(source._ready_write)
+          , _local(source._local)
+          , _peer(source._peer)
+          , _connecting(source._connecting)
+          , _shutdown_receive(source._shutdown_receive)
+          , _shutdown_send(source._shutdown_send)
+          , _read_timeout(source._read_timeout)
+          , _write_timeout(source._write_timeout)
+          , _read_operation(source._read_operation)
+          , _write_operation(source._write_operation)
+          , _connects(source._connects)
+          , _tuned(source._tuned)
+          , _options(std::move(source._options))
+          , _send_queue(std::move(source._send_queue))
+          , _send_queued(source._send_queued)
+          , _flushing(source._flushing)
+          , _writable_waiters(std::move(source._writable_waiters))
+          , _draining(source._draining)
+          , _congested(source._congested)
+          , _low_watermark(source._low_watermark)
+          , _high_watermark(source._high_watermark)
+          , _anchor(std::move(source._anchor))
+        {
+          // Pending flushes and drains now reach this socket.
+          *this->_anchor = this;
+          source._anchor = std::make_shared<socket*>(&source);
+          source._udt_socket = -1;
+          source._connecting = false;
+          source._tuned = 0;
+          source._send_queue.clear();
+          source._send_queued = 0;
+          source._flushing = false;
+          source._writable_waiters.clear();
+          source._draining = false;
+          source._congested = false;
+        }
+
+        socket&
+        socket::operator =(socket&& source)
+        {
+          if (&source == this)
+            return *this;
+          BOOST_ASSERT(&this->_service == &source._service);
+          this->_dispose();
+          this->_udt_socket = source._udt_socket;
+          this->_ready_read = source._ready_read;
+          this->_ready_write = source._ready_write;
+          this->_local = source._local;
+          this->_peer = source._peer;
+          this->_connecting = source._connecting;
+          this->_shutdown_receive = source._shutdown_receive;
+          this->_shutdown_send = source._shutdown_send;
+          this->_read_timeout = source._read_timeout;
+          this->_write_timeout = source._write_timeout;
+          this->_read_operation = source._read_operation;
+          this->_write_operation = source._write_operation;
+          this->_connects = source._connects;
+          this->_tuned = source._tuned;
+          this->_options = std::move(source._options);
+          this->_send_queue = std::move(source._send_queue);
+          this->_send_queued = source._send_queued;
+          this->_flushing = source._flushing;
+          this->_writable_waiters = std::move(source._writable_waiters);
+          this->_draining = source._draining;
+          this->_congested = source._congested;
+          this->_low_watermark = source._low_watermark;
+          this->_high_watermark = source._high_watermark;
+          this->_anchor = std::move(source._anchor);
+          *this->_anchor = this;
+          source._anchor = std::make_shared<socket*>(&source);
+          source._udt_socket = -1;
+          source._connecting = false;
+          source._tuned = 0;
+          source._send_queue.clear();
+          source._send_queued = 0;
+          source._flushing = false;
+          source._writable_waiters.clear();
+          source._draining = false;
+          source._congested = false;
+          return *this;
         }
 
         socket::~socket()
         {
-          if (this->_udt_socket != -1)
-            this->close();
+          this->_dispose();
+        }
+
+        socket*
+        socket::_anchored(Anchor const& anchor)
+        {
+          if (auto self = anchor.lock())
+            return *self;
+          return nullptr;
+        }
+
+        void
+        socket::_dispose()
+        {
+          *this->_anchor = nullptr;
+          if (this->_udt_socket == -1)
+            return;
+          // Never block nor throw: the reaper lingers in the background.
+          try
+          {
+            this->_abort_sends(boost::asio::error::operation_aborted);
+            this->async_close();
+          }
+          catch (std::exception const& e)
+          {
+            ELLE_WARN("%s: unable to close: %s", *this, e.what());
+          }
+          // Close without throwing leaves the descriptor to the reaper.
+          this->_udt_socket = -1;
         }
 
         void
@@ -74,9 +195,18 @@ namespace boost
           }
           if (err == UDT::ERROR)
           {
-            auto error = UDT::getlasterror();
-            code.assign(error.getErrorCode(), udt_category::get());
+            code = udt_error();
+            return;
           }
+          auto it = std::find_if(this->_options.begin(), this->_options.end(),
+                                 [&] (basic_option const& option)
+                                 {
+                                   return option.opt == opt.opt;
+                                 });
+          if (it == this->_options.end())
+            this->_options.push_back(opt);
+          else
+            it->value = opt.value;
         }
 
         void
@@ -84,10 +214,7 @@ namespace boost
         {
           boost::system::error_code error;
           this->set_option(opt, error);
-          if (error)
-          {
-            throw_udt();
-          }
+          asio::detail::throw_error(error, "set_option");
         }
 
         socket::socket(io_service& io_service, int fd,
@@ -99,15 +226,76 @@ namespace boost
           , _ready_write(false)
           , _peer(endpoint)
           , _connecting(false)
+          , _shutdown_receive(false)
+          , _shutdown_send(false)
+          , _read_timeout(posix_time::pos_infin)
+          , _write_timeout(posix_time::pos_infin)
+          , _read_operation(0)
+          , _write_operation(0)
+          , _connects(0)
+          , _tuned(0)
+          , _send_queued(0)
+          , _flushing(false)
+          , _draining(false)
+          , _congested(false)
+          , _low_watermark(256 * 1024)
+          , _high_watermark(1024 * 1024)
+          , _anchor(std::make_shared<socket*>(this))
+        {}
+
+        void
+        socket::_setup(system::error_code& error)
         {
           if (this->_udt_socket == -1)
-            throw_errno();
-          this->set_option(non_blocking{true});
+            error = udt_error();
+          else
+            this->set_option(non_blocking{true}, error);
         }
 
         void
-        socket::_handle_connect(std::function<void (system::error_code const&)>
-                                const& handler)
+        socket::_assign(int fd, endpoint_type const& endpoint,
+                        system::error_code& error)
+        {
+          // Never connected, closing does not linger.
+          if (this->_udt_socket != -1)
+          {
+            this->_untune();
+            UDT::close(this->_udt_socket);
+          }
+          this->_udt_socket = fd;
+          this->_peer = endpoint;
+          this->_connecting = false;
+          this->_shutdown_receive = false;
+          this->_shutdown_send = false;
+          this->set_option(non_blocking{true}, error);
+        }
+
+        void
+        socket::read_timeout(posix_time::time_duration const& timeout)
+        {
+          this->_read_timeout = timeout;
+        }
+
+        posix_time::time_duration
+        socket::read_timeout() const
+        {
+          return this->_read_timeout;
+        }
+
+        void
+        socket::write_timeout(posix_time::time_duration const& timeout)
+        {
+          this->_write_timeout = timeout;
+        }
+
+        posix_time::time_duration
+        socket::write_timeout() const
+        {
+          return this->_write_timeout;
+        }
+
+        system::error_code
+        socket::_connected()
         {
           this->_connecting = false;
           system::error_code err;
@@ -115,32 +303,30 @@ namespace boost
             // FIXME: actual error code is lost by UDT
             err = system::error_code(udt_category::ENOSERVER,
                                      udt_category::get());
-          this->get_io_service().post(boost::bind(handler, err));
+          return err;
         }
 
         void
-        socket::async_connect(endpoint_type const& peer,
-                              std::function<void (system::error_code const&)>
-                              const& handler)
+        socket::_connect(endpoint_type const& peer, system::error_code& error)
         {
           _peer = peer;
+          this->_untune();
+          auto address = peer.address();
+          this->_tuned =
+            this->_udt_service._tune(this->_udt_socket, &address, true);
           // std::cerr << "IP from asio: "
           //           << inet_ntoa(addr.sin_addr) << std::endl;
+          // Connecting an unbound socket may start UDT threads.
+          scoped_affinity affinity(this->_udt_service.udt_affinity());
           if (UDT::connect(this->_udt_socket, peer.data(),
                            peer.size()) == UDT::ERROR)
           {
-            std::stringstream ss;
-
-            ss << "connect(" << this->_udt_socket << ", " << peer << ")";
-            throw_udt(ss.str());
+            error = udt_error();
+            ELLE_TRACE("%s: connect to %s failed: %s",
+                       *this, peer, error.message());
+            return;
           }
           this->_connecting = true;
-          system::error_code canceled(system::errc::operation_canceled,
-                                      system::system_category());
-          this->_udt_service.register_write
-            (this,
-             std::bind(&socket::_handle_connect, this, handler),
-             std::bind(handler, canceled));
         }
 
         io_service&
@@ -149,55 +335,54 @@ namespace boost
           return _service;
         }
 
-        void
-        socket::async_read_some(
-          mutable_buffer buffer,
-          std::function<void (system::error_code const&,
-                              std::size_t)> const& handler)
+        bool
+        socket::_read_some(mutable_buffer buffer,
+                           system::error_code& error, std::size_t& read)
         {
           ELLE_TRACE_SCOPE("%s: read at most %s bytes",
                            *this, boost::asio::buffer_size(buffer));
+          if (this->_shutdown_receive)
+          {
+            error = boost::asio::error::eof;
+            return true;
+          }
           auto buf = buffer_cast<char*>(buffer);
           int size = buffer_size(buffer);
           ELLE_DEBUG("%s: try reading directly", *this);
-          int read = UDT::recv(_udt_socket, buf, size, 0);
-          if (read == -1
+          int res = UDT::recv(_udt_socket, buf, size, 0);
+          if (res == -1
               && UDT::getlasterror().getErrorCode() != udt_category::EASYNCRCV)
           {
-            system::error_code error;
             if (UDT::getlasterror().getErrorCode() == udt_category::ECONNLOST)
               error = boost::asio::error::eof;
             else
               error = system::error_code(UDT::getlasterror().getErrorCode(),
                                          udt_category::get());
-            ELLE_WARN("%s: post read error: %s", *this, error);
-            this->_service.post(std::bind(handler, error, read));
-            return;
+            ELLE_WARN("%s: read error: %s", *this, error);
+            return true;
           }
-          if (read > 0)
-          {
-            ELLE_DEBUG("%s: post successful read of %s bytes", *this, read);
-            this->_service.post(std::bind(handler, system::error_code(), read));
-          }
-          else
+          if (res > 0)
           {
-            auto action =
-              std::bind(&socket::async_read_some, this, buffer, handler);
-            system::error_code canceled(system::errc::operation_canceled,
-                                        system::system_category());
-            auto cancel = std::bind(handler, canceled, 0);
-            ELLE_DEBUG("%s: no data available", *this);
-            this->_udt_service.register_read(this, action, cancel);
+            ELLE_DEBUG("%s: successful read of %s bytes", *this, res);
+            instrument::received(res);
+            read = res;
+            return true;
           }
+          ELLE_DEBUG("%s: no data available", *this);
+          return false;
         }
 
-        void
-        socket::async_write_some(const_buffer buffer,
-                                 std::function<void (system::error_code const&,
-                                                     std::size_t)> const& handler)
+        bool
+        socket::_write_some(const_buffer buffer,
+                            system::error_code& error, std::size_t& written)
         {
           ELLE_TRACE_SCOPE("%s: write at most %s bytes",
                            *this, boost::asio::buffer_size(buffer));
+          if (this->_shutdown_send)
+          {
+            error = boost::asio::error::shut_down;
+            return true;
+          }
           auto buf = buffer_cast<char const*>(buffer);
           int size = buffer_size(buffer);
           ELLE_DEBUG("%s: try writing directly", *this);
@@ -205,35 +390,267 @@ namespace boost
           if (sent == -1
               && UDT::getlasterror().getErrorCode() != udt_category::EASYNCSND)
           {
-            system::error_code error(UDT::getlasterror().getErrorCode(),
-                                     udt_category::get());
-            ELLE_WARN("%s: post write error: %s", *this, error);
-            this->_service.post(std::bind(handler, error, sent));
-            return;
+            error = system::error_code(UDT::getlasterror().getErrorCode(),
+                                       udt_category::get());
+            ELLE_WARN("%s: write error: %s", *this, error);
+            return true;
           }
           if (sent > 0)
           {
-            ELLE_DEBUG("%s: post successful write of %s bytes", *this, sent);
-            this->_service.post(std::bind(handler, system::error_code(), sent));
+            ELLE_DEBUG("%s: successful write of %s bytes", *this, sent);
+            this->_udt_service._sending(this);
+            instrument::sent(sent);
+            written = sent;
+            return true;
           }
-          else
+          ELLE_DEBUG("%s: busy", *this);
+          return false;
+        }
+
+        std::size_t
+        socket::_payload() const
+        {
+          // The send buffer holds packets of MSS minus IP, UDP and UDT
+          // headers.
+          int mss = 1500;
+          int size = sizeof(mss);
+          UDT::getsockopt(this->_udt_socket, 0, UDT_MSS, &mss, &size);
+          return mss - 44;
+        }
+
+        std::size_t
+        socket::backlog() const
+        {
+          int pending = 0;
+          int size = sizeof(pending);
+          if (UDT::getsockopt(this->_udt_socket, 0, UDT_SNDDATA,
+                              &pending, &size) == UDT::ERROR)
+            return this->_send_queued;
+          return this->_send_queued + pending * this->_payload();
+        }
+
+        void
+        socket::watermarks(std::size_t low, std::size_t high)
+        {
+          this->_low_watermark = std::min(low, high);
+          this->_high_watermark = high;
+        }
+
+        std::size_t
+        socket::low_watermark() const
+        {
+          return this->_low_watermark;
+        }
+
+        std::size_t
+        socket::high_watermark() const
+        {
+          return this->_high_watermark;
+        }
+
+        bool
+        socket::writable()
+        {
+          if (this->_congested && this->backlog() <= this->_low_watermark)
+          {
+            ELLE_DEBUG("%s: writable again", *this);
+            this->_congested = false;
+          }
+          return !this->_congested;
+        }
+
+        void
+        socket::_send(const_buffer buffer, Sent done)
+        {
+          auto data = buffer_cast<char const*>(buffer);
+          this->_send(std::vector<char>(data, data + buffer_size(buffer)),
+                      std::move(done));
+        }
+
+        void
+        socket::_send(std::vector<char> data, Sent done)
+        {
+          this->_send(std::vector<char>(), std::move(data), std::move(done));
+        }
+
+        void
+        socket::_send(std::vector<char> head, std::vector<char> body,
+                      Sent done)
+        {
+          // Moving a vector keeps its storage, the buffer remains valid.
+          auto buffer = boost::asio::buffer(body);
+          this->_queue(
+            Send{std::move(head), std::move(body), buffer, 0,
+                 std::move(done)});
+        }
+
+        void
+        socket::_send(std::vector<char> head, const_buffer buffer,
+                      Sent done)
+        {
+          this->_queue(
+            Send{std::move(head), {}, buffer, 0, std::move(done)});
+        }
+
+        void
+        socket::_queue(Send send)
+        {
+          auto size = send.head.size() + buffer_size(send.buffer);
+          ELLE_TRACE_SCOPE("%s: queue %s bytes", *this, size);
+          this->_send_queue.push_back(std::move(send));
+          this->_send_queued += size;
+          if (!this->_flushing)
+            this->_flush();
+          // Queued bytes alone may be enough, spare querying UDT.
+          if (!this->_congested &&
+              (this->_send_queued >= this->_high_watermark ||
+               this->backlog() >= this->_high_watermark))
           {
-            auto action =
-              std::bind(&socket::async_write_some, this, buffer, handler);
-            system::error_code canceled(system::errc::operation_canceled,
-                                        system::system_category());
-            auto cancel = std::bind(handler, canceled, 0);
-            ELLE_DEBUG("%s: busy", *this);
-            this->_udt_service.register_write(this, action, cancel);
+            ELLE_DEBUG("%s: backlog reached the high watermark", *this);
+            this->_congested = true;
           }
         }
 
+        void
+        socket::_flush()
+        {
+          while (!this->_send_queue.empty())
+          {
+            auto& send = this->_send_queue.front();
+            system::error_code error;
+            std::size_t written = 0;
+            auto head = send.head.size();
+            auto size = head + buffer_size(send.buffer);
+            auto pending = send.sent < head ?
+              boost::asio::buffer(send.head) + send.sent :
+              send.buffer + (send.sent - head);
+            if (buffer_size(pending) != 0 &&
+                !this->_write_some(pending, error, written))
+            {
+              this->_flushing = true;
+              Anchor anchor = this->_anchor;
+              this->_udt_service.register_write
+                (this,
+                 [anchor] ()
+                 {
+                   if (auto self = _anchored(anchor))
+                   {
+                     self->_flushing = false;
+                     self->_flush();
+                   }
+                 },
+                 [anchor] (system::error_code const& error)
+                 {
+                   if (auto self = _anchored(anchor))
+                   {
+                     self->_flushing = false;
+                     self->_abort_sends(error);
+                   }
+                 },
+                 this->_write_timeout);
+              break;
+            }
+            if (error)
+              return this->_abort_sends(error);
+            send.sent += written;
+            this->_send_queued -= written;
+            if (send.sent == size)
+            {
+              auto done = std::move(send.done);
+              auto sent = send.sent;
+              this->_send_queue.pop_front();
+              done(error, sent);
+            }
+          }
+          this->_notify_writable();
+        }
+
+        void
+        socket::_abort_sends(system::error_code const& error)
+        {
+          ELLE_TRACE_SCOPE("%s: abort %s queued sends: %s",
+                           *this, this->_send_queue.size(), error.message());
+          auto sends = std::move(this->_send_queue);
+          this->_send_queue.clear();
+          this->_send_queued = 0;
+          for (auto& send: sends)
+            send.done(error, send.sent);
+          auto waiters = std::move(this->_writable_waiters);
+          this->_writable_waiters.clear();
+          for (auto& waiter: waiters)
+            waiter(error);
+        }
+
+        void
+        socket::_await_writable(Writable waiter)
+        {
+          if (this->writable())
+            return waiter(system::error_code());
+          this->_writable_waiters.push_back(std::move(waiter));
+          this->_notify_writable();
+        }
+
+        void
+        socket::_notify_writable()
+        {
+          if (this->_writable_waiters.empty() || this->_draining)
+            return;
+          if (this->writable())
+          {
+            auto waiters = std::move(this->_writable_waiters);
+            this->_writable_waiters.clear();
+            for (auto& waiter: waiters)
+              waiter(system::error_code());
+            return;
+          }
+          // Flushing notifies again on progress.
+          if (!this->_send_queue.empty())
+            return;
+          // Only the UDT send buffer is left: watch it shrink under the low
+          // watermark.
+          this->_draining = true;
+          Anchor anchor = this->_anchor;
+          this->_udt_service.register_drain
+            (this,
+             [anchor] ()
+             {
+               if (auto self = _anchored(anchor))
+               {
+                 self->_draining = false;
+                 self->_notify_writable();
+               }
+             },
+             [anchor] (system::error_code const& error)
+             {
+               auto self = _anchored(anchor);
+               if (!self)
+                 return;
+               self->_draining = false;
+               auto waiters = std::move(self->_writable_waiters);
+               self->_writable_waiters.clear();
+               for (auto& waiter: waiters)
+                 waiter(error);
+             },
+             service::Invoker(),
+             this->_low_watermark / this->_payload());
+        }
+
         void
         socket::bind(endpoint_type const& endpoint)
         {
+          system::error_code error;
+          this->bind(endpoint, error);
+          asio::detail::throw_error(error, "bind");
+        }
+
+        void
+        socket::bind(endpoint_type const& endpoint, system::error_code& error)
+        {
+          // Binding to a new port starts UDT threads.
+          scoped_affinity affinity(this->_udt_service.udt_affinity());
           if (UDT::bind(this->_udt_socket,
                         endpoint.data(), endpoint.size()) == UDT::ERROR)
-              throw_udt();
+            error = udt_error();
         }
 
         void
@@ -244,41 +661,173 @@ namespace boost
           this->bind(local_endpoint);
         }
 
+        void
+        socket::bind(unsigned short port, system::error_code& error)
+        {
+          endpoint_type local_endpoint{boost::asio::ip::udp::v4(), port};
+
+          this->bind(local_endpoint, error);
+        }
+
         void
         socket::_bind_fd(int fd)
         {
+          system::error_code error;
+          this->_bind_fd(fd, error);
+          asio::detail::throw_error(error, "bind");
+        }
+
+        void
+        socket::_bind_fd(int fd, system::error_code& error)
+        {
+          scoped_affinity affinity(this->_udt_service.udt_affinity());
           if (UDT::bind2(this->_udt_socket, fd) == UDT::ERROR)
-            throw_udt();
+            error = udt_error();
         }
 
         void
-        socket::shutdown(shutdown_type, system::error_code&)
+        socket::shutdown(shutdown_type type, system::error_code&)
         {
-          // FIXME: nothing ?
+          // UDT has no half-close: only stop accepting operations in the
+          // given direction.
+          if (type == shutdown_receive || type == shutdown_both)
+            this->_shutdown_receive = true;
+          if (type == shutdown_send || type == shutdown_both)
+            this->_shutdown_send = true;
+        }
+
+        bool
+        socket::_drained(system::error_code& error)
+        {
+          int pending = 0;
+          int size = sizeof(pending);
+          if (UDT::getsockopt(this->_udt_socket, 0, UDT_SNDDATA,
+                              &pending, &size) == UDT::ERROR)
+          {
+            error = system::error_code(UDT::getlasterror().getErrorCode(),
+                                       udt_category::get());
+            ELLE_WARN("%s: drain error: %s", *this, error);
+            return true;
+          }
+          if (pending == 0)
+          {
+            ELLE_DEBUG("%s: send buffer drained", *this);
+            return true;
+          }
+          ELLE_DEBUG("%s: %s packets left to send", *this, pending);
+          return false;
         }
 
         void
         socket::close()
         {
+          system::error_code error;
+          this->close(error);
+          asio::detail::throw_error(error, "close");
+        }
+
+        void
+        socket::close(system::error_code& error)
+        {
+          this->_udt_service._unschedule(this->_udt_socket);
+          this->_untune();
           if (UDT::close(this->_udt_socket) == UDT::ERROR)
-            throw_udt();
+            error = udt_error();
           else
             this->_udt_socket = -1;
         }
 
+        void
+        socket::async_close()
+        {
+          if (this->_udt_socket == -1)
+            return;
+          this->cancel_read();
+          this->cancel_write();
+          this->_udt_service.cancel_drain(this);
+          if (this->_connecting)
+          {
+            this->_connecting = false;
+            ++this->_connects;
+          }
+          this->_udt_service._unschedule(this->_udt_socket);
+          this->_untune();
+          this->_udt_service.reap(this->_udt_socket);
+          this->_udt_socket = -1;
+        }
+
+        void
+        socket::_untune()
+        {
+          this->_udt_service._untune(this->_udt_socket, this->_peer.address(),
+                                     this->_tuned);
+          this->_tuned = 0;
+        }
+
         void
         socket::cancel()
         {
-          this->_udt_service.cancel_read(this);
-          this->_udt_service.cancel_write(this);
+          system::error_code error;
+          this->cancel(error);
+          asio::detail::throw_error(error, "cancel");
+        }
+
+        void
+        socket::cancel(system::error_code& error)
+        {
+          this->cancel_read();
+          this->cancel_write();
+          this->_udt_service.cancel_drain(this);
           if (this->_connecting)
             {
               this->_connecting = false;
-              // FIXME: close socket to cancel out UDT connection
-              close();
+              // A connection action may already be posted: make it stale.
+              ++this->_connects;
+              // UDT cannot abort a connection attempt: close the connecting
+              // socket in the background and start over with a fresh one.
+              this->_udt_service._unschedule(this->_udt_socket);
+              this->_untune();
+              this->_udt_service.reap(this->_udt_socket);
+              this->_udt_socket = UDT::socket(AF_INET, SOCK_STREAM, 0);
+              if (this->_udt_socket == -1)
+              {
+                error = udt_error();
+                return;
+              }
+              auto options = this->_options;
+              for (auto const& option: options)
+              {
+                this->set_option(option, error);
+                if (error)
+                  return;
+              }
             }
         }
 
+        void
+        socket::cancel_read(std::uint64_t operation)
+        {
+          this->_udt_service.cancel_read(this, operation);
+        }
+
+        void
+        socket::cancel_write(std::uint64_t operation)
+        {
+          this->_udt_service.cancel_write(this, operation);
+        }
+
+        std::uint64_t
+        socket::read_operation() const
+        {
+          return this->_read_operation;
+        }
+
+        std::uint64_t
+        socket::write_operation() const
+        {
+          return this->_write_operation;
+        }
+
         socket::endpoint_type
         socket::local_endpoint() const
         {
@@ -1,11 +1,19 @@
 #ifndef ASIO_UDT_SOCKET_HH
 # define ASIO_UDT_SOCKET_HH
 
+# include <cstdint>
+# include <deque>
+# include <functional>
+# include <memory>
+# include <utility>
+# include <vector>
+
 # include <boost/asio.hpp>
 # include <boost/noncopyable.hpp>
 
 # include <udt/udt.h>
 
+# include <asio-udt/buffer-pool.hh>
 # include <asio-udt/fwd.hh>
 
 namespace boost
@@ -54,11 +62,34 @@ namespace boost
           public:
             explicit
             socket(io_service& io_service);
+            /// Take over source UDT socket and queued sends, leaving
+            /// source closed. Sockets with other pending operations must not
+            /// be moved.
+            socket(socket&& source);
+            /// Close this as the destructor does, then take over source,
+            /// which must belong to the same io_service.
+            socket&
+            operator =(socket&& source);
+            /// Abort pending operations and close as async_close does,
+            /// without blocking nor throwing.
             ~socket();
 
           private:
+            /// Take fd over, see _setup.
             socket(io_service& io_service, int fd,
                    endpoint_type const& endpoint);
+            /// Check the UDT socket and make it non-blocking.
+            void
+            _setup(system::error_code& error);
+            /// Replace the unconnected UDT socket by fd, connected to
+            /// endpoint.
+            void
+            _assign(int fd, endpoint_type const& endpoint,
+                    system::error_code& error);
+            /// Detach from internal reactor callbacks and close in the
+            /// background, without throwing.
+            void
+            _dispose();
 
           public:
             void
@@ -69,22 +100,112 @@ namespace boost
                        boost::system::error_code& code);
 
           public:
+            /// Abort reads that are not completed within timeout with
+            /// timed_out. Infinite by default.
+            void
+            read_timeout(posix_time::time_duration const& timeout);
+            posix_time::time_duration
+            read_timeout() const;
+            /// Abort writes that are not completed within timeout with
+            /// timed_out. Infinite by default.
             void
-            async_connect(endpoint_type const& endpoint,
-                          std::function<void (boost::system::error_code const&)>
-                          const& handler);
+            write_timeout(posix_time::time_duration const& timeout);
+            posix_time::time_duration
+            write_timeout() const;
+
+          public:
+            /// Asynchronous operations accept any completion token: plain
+            /// handlers, use_future, yield_context, use_awaitable...
+            /// Handlers are run through their associated executor and
+            /// asio_handler_invoke hook, both when completing from the
+            /// reactor and when posting an immediate completion. They never
+            /// throw: failures are delivered to the handler.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler, void (system::error_code))
+            async_connect(endpoint_type const& endpoint, Handler&& handler);
             io_service&
             get_io_service();
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::size_t))
+            async_read_some(mutable_buffer buffer, Handler&& handler);
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::size_t))
+            async_write_some(const_buffer buffer, Handler&& handler);
+            enum wait_type
+            {
+              wait_read,
+              wait_write,
+            };
+            /// Complete once the socket is ready for type, without
+            /// consuming nor pinning any buffer. Subject to the read or
+            /// write timeout. Read waits fail with eof once reception is
+            /// shut down.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler, void (system::error_code))
+            async_wait(wait_type type, Handler&& handler);
+            /// Reactor-style operations: complete with 0 bytes once the
+            /// socket is readable, respectively writable.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::size_t))
+            async_read_some(null_buffers const&, Handler&& handler);
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::size_t))
+            async_write_some(null_buffers const&, Handler&& handler);
+            /// Read into a slab of the service buffer pool, taken only once
+            /// data is available. Completes with no_buffer_space if the
+            /// pool is exhausted then.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                buffer_pool::slab))
+            async_receive(Handler&& handler);
+            /// Queue a copy of buffer for sending, completing once it was
+            /// entirely handed to UDT. Sends are written in order and must
+            /// not be mixed with pending async_write_some.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::size_t))
+            async_send(const_buffer buffer, Handler&& handler);
+            /// Bytes queued by async_send plus bytes in the UDT send
+            /// buffer.
+            std::size_t
+            backlog() const;
+            /// Backpressure thresholds on the backlog, in bytes. Once the
+            /// backlog reaches high, the socket is not writable until it
+            /// falls back to low. 256KiB and 1MiB by default.
             void
-            async_read_some(mutable_buffer buffer,
-                            std::function<void (system::error_code const&,
-                                                std::size_t)> const& handler);
-            void
-            async_write_some(const_buffer buffer,
-                             std::function<void (system::error_code const&,
-                                                 std::size_t)> const& handler);
+            watermarks(std::size_t low, std::size_t high);
+            std::size_t
+            low_watermark() const;
+            std::size_t
+            high_watermark() const;
+            /// Whether producers may send more without exceeding the high
+            /// watermark.
+            bool
+            writable();
+            /// Complete once the socket is writable again, right away if it
+            /// is. Must not be pending together with async_shutdown.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler, void (system::error_code))
+            async_writable(Handler&& handler);
             void
             close();
+            void
+            close(system::error_code& error);
+            /// Close without blocking: pending operations are canceled and
+            /// the UDT socket is handed to the service reaper, which lingers
+            /// in the background.
+            void
+            async_close();
             enum shutdown_type
             {
               shutdown_receive,
@@ -93,24 +214,106 @@ namespace boost
             };
             void
             shutdown(shutdown_type, system::error_code&);
+            /// Shutdown and, when sending is shut down, complete once UDT
+            /// send buffer is drained.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler, void (system::error_code))
+            async_shutdown(shutdown_type type, Handler&& handler);
+            /// Abort all pending operations with operation_aborted. A pending
+            /// connection is aborted but the socket remains open, with the
+            /// options set so far.
             void
             cancel();
+            void
+            cancel(system::error_code& error);
+            /// Abort the pending read operation only. If operation is not
+            /// 0, abort it only if it is still pending, and not whichever
+            /// read followed.
+            void
+            cancel_read(std::uint64_t operation = 0);
+            /// Abort the pending write or connect operation only, or only
+            /// operation if not 0.
+            void
+            cancel_write(std::uint64_t operation = 0);
+            /// Identifier of the last read operation that had to wait, to
+            /// cancel it alone. Operations completing right away have none.
+            std::uint64_t
+            read_operation() const;
+            /// Identifier of the last write or connect operation that had
+            /// to wait.
+            std::uint64_t
+            write_operation() const;
             endpoint_type
             local_endpoint() const;
             endpoint_type
             remote_endpoint() const;
 
           private:
+            /// Operations attempts. Return whether the operation completed,
+            /// false meaning it would block.
             void
-            _handle_connect(std::function<void (system::error_code const&)>
-                            const& handler);
+            _connect(endpoint_type const& peer, system::error_code& error);
+            system::error_code
+            _connected();
+            bool
+            _read_some(mutable_buffer buffer,
+                       system::error_code& error, std::size_t& read);
+            bool
+            _write_some(const_buffer buffer,
+                        system::error_code& error, std::size_t& written);
+            bool
+            _drained(system::error_code& error);
+            /// Payload bytes of a UDT send buffer packet.
+            std::size_t
+            _payload() const;
+
+            /// Asynchronous operations. Deferred operations are run from
+            /// the reactor, through the handler invoker.
+            template <typename Handler>
+            void
+            _async_read_some(mutable_buffer buffer, Handler handler,
+                             bool deferred);
+            template <typename Handler>
+            void
+            _async_write_some(const_buffer buffer, Handler handler,
+                              bool deferred);
+            template <typename Handler>
+            void
+            _async_drain(Handler handler, bool deferred);
+            template <typename Handler>
+            void
+            _async_receive(Handler handler);
+            /// Complete handler with args once ready for type.
+            template <typename Handler, typename ... Args>
+            void
+            _async_wait(wait_type type, Handler handler, Args const& ... args);
+            /// async_initiate initiations.
+            struct _initiate_connect;
+            struct _initiate_read_some;
+            struct _initiate_write_some;
+            struct _initiate_shutdown;
+            struct _initiate_wait;
+            struct _initiate_receive;
+            struct _initiate_send;
+            struct _initiate_writable;
+            /// Invoke handler directly if deferred, post it otherwise.
+            template <typename Handler, typename ... Args>
+            void
+            _complete(bool deferred, Handler& handler, Args const& ... args);
 
             friend class acceptor;
+            friend class broadcast;
+            friend class connection_pool;
+            friend class framed_socket;
             friend class service;
           public: // FIXME
             void bind(endpoint_type const& endpoint);
+            void bind(endpoint_type const& endpoint,
+                      system::error_code& error);
             void bind(unsigned short port);
+            void bind(unsigned short port, system::error_code& error);
             void _bind_fd(int fd);
+            void _bind_fd(int fd, system::error_code& error);
           private:
             io_service& _service;
             service& _udt_service;
@@ -120,10 +323,86 @@ namespace boost
             endpoint_type _local;
             endpoint_type _peer;
             bool _connecting;
+            bool _shutdown_receive;
+            bool _shutdown_send;
+            posix_time::time_duration _read_timeout;
+            posix_time::time_duration _write_timeout;
+            std::uint64_t _read_operation;
+            std::uint64_t _write_operation;
+            /// Connection attempts, actions of aborted ones are stale.
+            std::uint64_t _connects;
+            /// Buffer bytes granted by the service autotuning.
+            std::size_t _tuned;
+            /// Options set, to apply again when the UDT socket is replaced.
+            std::vector<basic_option> _options;
+            /// Report measures and release granted buffers.
+            void
+            _untune();
+
+          private:
+            typedef std::function<void (system::error_code const&,
+                                        std::size_t)> Sent;
+            typedef std::function<void (system::error_code const&)> Writable;
+            /// Head, then buffer: either body or memory of the caller.
+            struct Send
+            {
+              std::vector<char> head;
+              std::vector<char> body;
+              const_buffer buffer;
+              std::size_t sent;
+              Sent done;
+            };
+            void
+            _send(const_buffer buffer, Sent done);
+            /// Queue data as one send, sparing the copy.
+            void
+            _send(std::vector<char> data, Sent done);
+            /// Queue head and body as one send, sparing the copies.
+            void
+            _send(std::vector<char> head, std::vector<char> body, Sent done);
+            /// Queue head and buffer as one send, without copying buffer:
+            /// it must remain valid until done.
+            void
+            _send(std::vector<char> head, const_buffer buffer, Sent done);
+            void
+            _queue(Send send);
+            /// Write queued sends until UDT would block.
+            void
+            _flush();
+            /// Fail queued sends with error.
+            void
+            _abort_sends(system::error_code const& error);
+            void
+            _await_writable(Writable waiter);
+            /// Complete writable waiters if the backlog is low enough,
+            /// otherwise make sure progress is watched.
+            void
+            _notify_writable();
+            std::deque<Send> _send_queue;
+            std::size_t _send_queued;
+            /// Whether a flush waits for UDT to accept more data.
+            bool _flushing;
+            std::vector<Writable> _writable_waiters;
+            /// Whether the UDT send buffer is watched for writable waiters.
+            bool _draining;
+            bool _congested;
+            std::size_t _low_watermark;
+            std::size_t _high_watermark;
+            /// This socket, or null once destroyed: reactor actions and
+            /// cancellations may run after the socket moved or is gone, so
+            /// they hold an Anchor and resolve it when run.
+            std::shared_ptr<socket*> _anchor;
+            typedef std::weak_ptr<socket*> Anchor;
+            /// The socket anchor designates now, or null.
+            static
+            socket*
+            _anchored(Anchor const& anchor);
         };
       }
     }
   }
 }
 
+# include <asio-udt/socket.hxx>
+
 #endif
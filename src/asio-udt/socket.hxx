@@ -1,4 +1,455 @@
 #ifndef ASIO_UDT_SOCKET_HXX
 # define ASIO_UDT_SOCKET_HXX
 
+# include <memory>
+
+# include <boost/asio/async_result.hpp>
+# include <boost/asio/detail/bind_handler.hpp>
+
+# include <asio-udt/service.hh>
+# include <asio-udt/statistics.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        struct socket::_initiate_connect
+        {
+          socket* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler, endpoint_type const& peer) const
+          {
+            typedef typename std::decay<Handler>::type Completion;
+            auto self = this->self;
+            system::error_code error;
+            self->_connect(peer, error);
+            if (error)
+            {
+              Completion h(std::forward<Handler>(handler));
+              return self->_complete(false, h, error);
+            }
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            auto attempt = self->_connects;
+            Anchor anchor = self->_anchor;
+            self->_udt_service.register_write
+              (self,
+               [anchor, h, attempt] ()
+               {
+                 auto self = _anchored(anchor);
+                 // Gone, or cancelled once ready: the socket is a fresh one.
+                 if (!self || attempt != self->_connects)
+                   return (*h)(boost::asio::error::operation_aborted);
+                 (*h)(self->_connected());
+               },
+               [h] (system::error_code const& error)
+               {
+                 (*h)(error);
+               },
+               posix_time::pos_infin,
+               service::invoker(self->_service, h));
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler, void (system::error_code))
+        socket::async_connect(endpoint_type const& peer, Handler&& handler)
+        {
+          return async_initiate<Handler, void (system::error_code)>(
+            _initiate_connect{this}, handler, peer);
+        }
+
+        struct socket::_initiate_read_some
+        {
+          socket* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler, mutable_buffer buffer) const
+          {
+            this->self->_async_read_some(
+              buffer,
+              typename std::decay<Handler>::type(
+                std::forward<Handler>(handler)),
+              false);
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, std::size_t))
+        socket::async_read_some(mutable_buffer buffer, Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, std::size_t)>(
+            _initiate_read_some{this}, handler, buffer);
+        }
+
+        template <typename Handler>
+        void
+        socket::_async_read_some(mutable_buffer buffer, Handler handler,
+                                 bool deferred)
+        {
+          system::error_code error;
+          std::size_t read = 0;
+          if (this->_read_some(buffer, error, read))
+            return this->_complete(deferred, handler, error, read);
+          auto h = std::make_shared<Handler>(std::move(handler));
+          Anchor anchor = this->_anchor;
+          this->_udt_service.register_read
+            (this,
+             [anchor, buffer, h] ()
+             {
+               auto self = _anchored(anchor);
+               if (!self)
+                 return (*h)(boost::asio::error::operation_aborted, 0);
+               self->_async_read_some(buffer, std::move(*h), true);
+             },
+             [h] (system::error_code const& error)
+             {
+               (*h)(error, 0);
+             },
+             this->_read_timeout,
+             service::invoker(this->_service, h));
+        }
+
+        struct socket::_initiate_write_some
+        {
+          socket* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler, const_buffer buffer) const
+          {
+            this->self->_async_write_some(
+              buffer,
+              typename std::decay<Handler>::type(
+                std::forward<Handler>(handler)),
+              false);
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, std::size_t))
+        socket::async_write_some(const_buffer buffer, Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, std::size_t)>(
+            _initiate_write_some{this}, handler, buffer);
+        }
+
+        template <typename Handler>
+        void
+        socket::_async_write_some(const_buffer buffer, Handler handler,
+                                  bool deferred)
+        {
+          system::error_code error;
+          std::size_t written = 0;
+          if (this->_write_some(buffer, error, written))
+            return this->_complete(deferred, handler, error, written);
+          auto h = std::make_shared<Handler>(std::move(handler));
+          Anchor anchor = this->_anchor;
+          this->_udt_service.register_write
+            (this,
+             [anchor, buffer, h] ()
+             {
+               auto self = _anchored(anchor);
+               if (!self)
+                 return (*h)(boost::asio::error::operation_aborted, 0);
+               self->_async_write_some(buffer, std::move(*h), true);
+             },
+             [h] (system::error_code const& error)
+             {
+               (*h)(error, 0);
+             },
+             this->_write_timeout,
+             service::invoker(this->_service, h));
+        }
+
+        struct socket::_initiate_wait
+        {
+          socket* self;
+
+          template <typename Handler, typename ... Args>
+          void
+          operator ()(Handler&& handler, wait_type type,
+                      Args const& ... args) const
+          {
+            this->self->_async_wait(
+              type,
+              typename std::decay<Handler>::type(
+                std::forward<Handler>(handler)),
+              args...);
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler, void (system::error_code))
+        socket::async_wait(wait_type type, Handler&& handler)
+        {
+          return async_initiate<Handler, void (system::error_code)>(
+            _initiate_wait{this}, handler, type);
+        }
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, std::size_t))
+        socket::async_read_some(null_buffers const&, Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, std::size_t)>(
+            _initiate_wait{this}, handler, wait_read, std::size_t(0));
+        }
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, std::size_t))
+        socket::async_write_some(null_buffers const&, Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, std::size_t)>(
+            _initiate_wait{this}, handler, wait_write, std::size_t(0));
+        }
+
+        template <typename Handler, typename ... Args>
+        void
+        socket::_async_wait(wait_type type, Handler handler,
+                            Args const& ... args)
+        {
+          // Nothing is read past shutdown, never wait for it.
+          if (type == wait_read && this->_shutdown_receive)
+            return this->_complete(false, handler, boost::asio::error::eof,
+                                   args...);
+          auto h = std::make_shared<Handler>(std::move(handler));
+          auto action = [h, args...] ()
+            {
+              (*h)(system::error_code(), args...);
+            };
+          auto cancel = [h, args...] (system::error_code const& error)
+            {
+              (*h)(error, args...);
+            };
+          if (type == wait_read)
+            this->_udt_service.register_read
+              (this, action, cancel, this->_read_timeout,
+               service::invoker(this->_service, h));
+          else
+            this->_udt_service.register_write
+              (this, action, cancel, this->_write_timeout,
+               service::invoker(this->_service, h));
+        }
+
+        struct socket::_initiate_receive
+        {
+          socket* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler) const
+          {
+            this->self->_async_receive(
+              typename std::decay<Handler>::type(
+                std::forward<Handler>(handler)));
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code,
+                                            buffer_pool::slab))
+        socket::async_receive(Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, buffer_pool::slab)>(
+            _initiate_receive{this}, handler);
+        }
+
+        template <typename Handler>
+        void
+        socket::_async_receive(Handler handler)
+        {
+          if (this->_shutdown_receive)
+          {
+            buffer_pool::slab none;
+            return this->_complete(false, handler,
+                                   boost::asio::error::eof, none);
+          }
+          // No slab is held while waiting: wait for readiness first, as
+          // data already received is reported right away.
+          auto h = std::make_shared<Handler>(std::move(handler));
+          Anchor anchor = this->_anchor;
+          this->_udt_service.register_read
+            (this,
+             [anchor, h] ()
+             {
+               auto self = _anchored(anchor);
+               if (!self)
+                 return (*h)(boost::asio::error::operation_aborted,
+                             buffer_pool::slab());
+               auto slab = self->_udt_service.buffers().acquire();
+               if (!slab)
+                 return (*h)(boost::asio::error::no_buffer_space,
+                             std::move(slab));
+               system::error_code error;
+               std::size_t read = 0;
+               if (self->_read_some(buffer(slab.data(), slab.capacity()),
+                                    error, read))
+               {
+                 slab._size = read;
+                 return (*h)(error, std::move(slab));
+               }
+               slab.release();
+               self->_async_receive(std::move(*h));
+             },
+             [h] (system::error_code const& error)
+             {
+               (*h)(error, buffer_pool::slab());
+             },
+             this->_read_timeout,
+             service::invoker(this->_service, h));
+        }
+
+        struct socket::_initiate_send
+        {
+          socket* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler, const_buffer buffer) const
+          {
+            typedef typename std::decay<Handler>::type Completion;
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            // Sends are aborted on destruction, from the socket at hand:
+            // only its io_service is needed to complete.
+            auto& service = this->self->_service;
+            this->self->_send(
+              buffer,
+              [&service, h] (system::error_code const& error,
+                             std::size_t sent)
+              {
+                instrument::completion(false);
+                asio::post(service,
+                           asio::detail::bind_handler(std::move(*h),
+                                                      error, sent));
+              });
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, std::size_t))
+        socket::async_send(const_buffer buffer, Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, std::size_t)>(
+            _initiate_send{this}, handler, buffer);
+        }
+
+        struct socket::_initiate_writable
+        {
+          socket* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler) const
+          {
+            typedef typename std::decay<Handler>::type Completion;
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            auto& service = this->self->_service;
+            this->self->_await_writable(
+              [&service, h] (system::error_code const& error)
+              {
+                instrument::completion(false);
+                asio::post(service,
+                           asio::detail::bind_handler(std::move(*h), error));
+              });
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler, void (system::error_code))
+        socket::async_writable(Handler&& handler)
+        {
+          return async_initiate<Handler, void (system::error_code)>(
+            _initiate_writable{this}, handler);
+        }
+
+        struct socket::_initiate_shutdown
+        {
+          socket* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler, shutdown_type type) const
+          {
+            typename std::decay<Handler>::type h(
+              std::forward<Handler>(handler));
+            system::error_code error;
+            this->self->shutdown(type, error);
+            if (type == shutdown_receive)
+              this->self->_complete(false, h, error);
+            else
+              this->self->_async_drain(std::move(h), false);
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler, void (system::error_code))
+        socket::async_shutdown(shutdown_type type, Handler&& handler)
+        {
+          return async_initiate<Handler, void (system::error_code)>(
+            _initiate_shutdown{this}, handler, type);
+        }
+
+        template <typename Handler>
+        void
+        socket::_async_drain(Handler handler, bool deferred)
+        {
+          system::error_code error;
+          if (this->_drained(error))
+            return this->_complete(deferred, handler, error);
+          auto h = std::make_shared<Handler>(std::move(handler));
+          Anchor anchor = this->_anchor;
+          this->_udt_service.register_drain
+            (this,
+             [anchor, h] ()
+             {
+               auto self = _anchored(anchor);
+               if (!self)
+                 return (*h)(boost::asio::error::operation_aborted);
+               self->_async_drain(std::move(*h), true);
+             },
+             [h] (system::error_code const& error)
+             {
+               (*h)(error);
+             },
+             service::invoker(this->_service, h));
+        }
+
+        template <typename Handler, typename ... Args>
+        void
+        socket::_complete(bool deferred, Handler& handler, Args const& ... args)
+        {
+          instrument::completion(deferred);
+          if (deferred)
+            handler(args...);
+          else
+            asio::post(
+              this->_service,
+              asio::detail::bind_handler(std::move(handler), args...));
+        }
+      }
+    }
+  }
+}
+
 #endif
@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <set>
+
+#include <boost/thread/mutex.hpp>
+
+#include <asio-udt/statistics.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        histogram::histogram()
+          : counts()
+          , sum(0)
+        {}
+
+        std::uint64_t
+        histogram::count() const
+        {
+          std::uint64_t res = 0;
+          for (auto count: this->counts)
+            res += count;
+          return res;
+        }
+
+        double
+        histogram::mean() const
+        {
+          auto count = this->count();
+          return count ? double(this->sum) / count : 0;
+        }
+
+        std::uint64_t
+        histogram::percentile(double p) const
+        {
+          auto count = this->count();
+          auto rank = std::max<std::uint64_t>(
+            static_cast<std::uint64_t>(std::ceil(p * count)), 1);
+          std::uint64_t seen = 0;
+          int i = 0;
+          for (; i < buckets - 1; ++i)
+          {
+            seen += this->counts[i];
+            if (seen >= rank)
+              break;
+          }
+          if (i == 0)
+            return 0;
+          if (i == 64)
+            return ~std::uint64_t(0);
+          return (std::uint64_t(1) << i) - 1;
+        }
+
+        histogram&
+        histogram::operator +=(histogram const& other)
+        {
+          for (int i = 0; i < buckets; ++i)
+            this->counts[i] += other.counts[i];
+          this->sum += other.sum;
+          return *this;
+        }
+
+        statistics::statistics()
+          : wakeups(0)
+          , registrations(0)
+          , cancellations(0)
+          , immediate(0)
+          , deferred(0)
+        {}
+
+        statistics&
+        statistics::operator +=(statistics const& other)
+        {
+          this->wakeups += other.wakeups;
+          this->events += other.events;
+          this->registrations += other.registrations;
+          this->cancellations += other.cancellations;
+          this->lock_wait += other.lock_wait;
+          this->dispatch_delay += other.dispatch_delay;
+          this->immediate += other.immediate;
+          this->deferred += other.deferred;
+          this->sent += other.sent;
+          this->received += other.received;
+          return *this;
+        }
+
+        namespace
+        {
+          /// Counter written by its thread only: a relaxed load and store,
+          /// not a locked read-modify-write, and still safe to read from
+          /// the snapshot.
+          struct Counter
+          {
+            Counter()
+              : value(0)
+            {}
+
+            void
+            add(std::uint64_t n)
+            {
+              this->value.store(
+                this->value.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+            }
+
+            std::uint64_t
+            get() const
+            {
+              return this->value.load(std::memory_order_relaxed);
+            }
+
+            std::atomic<std::uint64_t> value;
+          };
+
+          struct Histogram
+          {
+            void
+            record(std::uint64_t value)
+            {
+              // Shifting by 64 is undefined: the top bucket is reached
+              // without.
+              int bucket = 0;
+              while (bucket < 64 && value >> bucket)
+                ++bucket;
+              this->counts[bucket].add(1);
+              this->sum.add(value);
+            }
+
+            void
+            collect(histogram& h) const
+            {
+              for (int i = 0; i < histogram::buckets; ++i)
+                h.counts[i] += this->counts[i].get();
+              h.sum += this->sum.get();
+            }
+
+            Counter counts[histogram::buckets];
+            Counter sum;
+          };
+
+          struct Block
+          {
+            void
+            collect(statistics& s) const
+            {
+              s.wakeups += this->wakeups.get();
+              this->events.collect(s.events);
+              s.registrations += this->registrations.get();
+              s.cancellations += this->cancellations.get();
+              this->lock_wait.collect(s.lock_wait);
+              this->dispatch_delay.collect(s.dispatch_delay);
+              s.immediate += this->immediate.get();
+              s.deferred += this->deferred.get();
+              this->sent.collect(s.sent);
+              this->received.collect(s.received);
+            }
+
+            Counter wakeups;
+            Histogram events;
+            Counter registrations;
+            Counter cancellations;
+            Histogram lock_wait;
+            Histogram dispatch_delay;
+            Counter immediate;
+            Counter deferred;
+            Histogram sent;
+            Histogram received;
+          };
+
+          struct Registry
+          {
+            boost::mutex lock;
+            std::set<Block const*> blocks;
+            /// Statistics of threads that exited.
+            statistics retired;
+          };
+
+          Registry&
+          registry()
+          {
+            static Registry registry;
+            return registry;
+          }
+
+          struct Local
+          {
+            Local()
+            {
+              boost::mutex::scoped_lock lock(registry().lock);
+              registry().blocks.insert(&this->block);
+            }
+
+            ~Local()
+            {
+              boost::mutex::scoped_lock lock(registry().lock);
+              this->block.collect(registry().retired);
+              registry().blocks.erase(&this->block);
+            }
+
+            Block block;
+          };
+
+          Block&
+          local()
+          {
+            static thread_local Local local;
+            return local.block;
+          }
+
+          std::uint64_t
+          nanoseconds(instrument::Duration duration)
+          {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+              duration).count();
+          }
+        }
+
+        void
+        statistics::enable(bool enabled)
+        {
+          instrument::_enabled.store(enabled, std::memory_order_relaxed);
+        }
+
+        statistics
+        statistics::snapshot()
+        {
+          auto& all = registry();
+          boost::mutex::scoped_lock lock(all.lock);
+          statistics res = all.retired;
+          for (auto block: all.blocks)
+            block->collect(res);
+          return res;
+        }
+
+        namespace instrument
+        {
+          std::atomic<bool> _enabled(true);
+
+          void
+          wakeup(std::size_t events)
+          {
+            if (!enabled())
+              return;
+            auto& block = local();
+            block.wakeups.add(1);
+            block.events.record(events);
+          }
+
+          void
+          registration()
+          {
+            if (!enabled())
+              return;
+            local().registrations.add(1);
+          }
+
+          void
+          cancellation()
+          {
+            if (!enabled())
+              return;
+            local().cancellations.add(1);
+          }
+
+          void
+          lock_wait(Duration duration)
+          {
+            if (!enabled())
+              return;
+            local().lock_wait.record(nanoseconds(duration));
+          }
+
+          void
+          dispatch_delay(Duration duration)
+          {
+            if (!enabled())
+              return;
+            local().dispatch_delay.record(nanoseconds(duration));
+          }
+
+          void
+          completion(bool deferred)
+          {
+            if (!enabled())
+              return;
+            if (deferred)
+              local().deferred.add(1);
+            else
+              local().immediate.add(1);
+          }
+
+          void
+          sent(std::size_t bytes)
+          {
+            if (!enabled())
+              return;
+            local().sent.record(bytes);
+          }
+
+          void
+          received(std::size_t bytes)
+          {
+            if (!enabled())
+              return;
+            local().received.record(bytes);
+          }
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,124 @@
+#ifndef ASIO_UDT_STATISTICS_HH
+# define ASIO_UDT_STATISTICS_HH
+
+# include <atomic>
+# include <chrono>
+# include <cstdint>
+
+/// Build with ASIO_UDT_STATISTICS defined to 0 to compile instrumentation
+/// out.
+# ifndef ASIO_UDT_STATISTICS
+#  define ASIO_UDT_STATISTICS 1
+# endif
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Distribution of values in power of two buckets: bucket i counts
+        /// values in [2^(i-1), 2^i), bucket 0 counts zeros.
+        struct histogram
+        {
+          static int const buckets = 65;
+
+          histogram();
+          std::uint64_t counts[buckets];
+          std::uint64_t sum;
+
+          std::uint64_t
+          count() const;
+          double
+          mean() const;
+          /// Upper bound of the bucket holding the p-th percentile, p in
+          /// [0, 1].
+          std::uint64_t
+          percentile(double p) const;
+          histogram&
+          operator +=(histogram const& other);
+        };
+
+        /// Reactor and socket instrumentation, for all services of the
+        /// process.
+        ///
+        /// Every thread records in its own counters, summed up on snapshot
+        /// only: recording never contends with other threads.
+        struct statistics
+        {
+          statistics();
+
+          /// Reactor wakeups, and ready sockets per wakeup.
+          std::uint64_t wakeups;
+          histogram events;
+          std::uint64_t registrations;
+          std::uint64_t cancellations;
+          /// Time spent waiting for the service lock, in nanoseconds.
+          histogram lock_wait;
+          /// Time from readiness to the ready action running, in
+          /// nanoseconds.
+          histogram dispatch_delay;
+          /// Operations completed without, respectively after, waiting for
+          /// readiness.
+          std::uint64_t immediate;
+          std::uint64_t deferred;
+          /// Bytes per successful UDT::send and UDT::recv.
+          histogram sent;
+          histogram received;
+
+          statistics&
+          operator +=(statistics const& other);
+          /// Sum of the statistics of all threads so far.
+          static
+          statistics
+          snapshot();
+          /// Turn recording on or off at runtime, on by default.
+          static
+          void
+          enable(bool enabled);
+        };
+
+        /// Recording, for the service and sockets.
+        namespace instrument
+        {
+          typedef std::chrono::steady_clock::duration Duration;
+
+          extern std::atomic<bool> _enabled;
+
+          /// Whether recording is on: callers skip measuring otherwise.
+          inline
+          bool
+          enabled()
+          {
+# if ASIO_UDT_STATISTICS
+            return _enabled.load(std::memory_order_relaxed);
+# else
+            return false;
+# endif
+          }
+
+          void
+          wakeup(std::size_t events);
+          void
+          registration();
+          void
+          cancellation();
+          void
+          lock_wait(Duration duration);
+          void
+          dispatch_delay(Duration duration);
+          void
+          completion(bool deferred);
+          void
+          sent(std::size_t bytes);
+          void
+          received(std::size_t bytes);
+        }
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <asio-udt/striped-stream.hh>
+
+#include <elle/log.hh>
+
+ELLE_LOG_COMPONENT("boost.asio.ip.udt.striped_stream");
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Chunk header: big endian 64-bit sequence and 32-bit size.
+        static std::size_t const header_size = 12;
+        /// Reject bogus headers rather than allocating them.
+        static std::uint32_t const max_chunk_size = 1 << 24;
+
+        static
+        void
+        encode_header(char* header, std::uint64_t sequence, std::uint32_t size)
+        {
+          for (int i = 0; i < 8; ++i)
+            header[i] = (sequence >> (56 - 8 * i)) & 0xff;
+          for (int i = 0; i < 4; ++i)
+            header[8 + i] = (size >> (24 - 8 * i)) & 0xff;
+        }
+
+        static
+        void
+        decode_header(char const* header,
+                      std::uint64_t& sequence, std::uint32_t& size)
+        {
+          sequence = 0;
+          for (int i = 0; i < 8; ++i)
+            sequence = (sequence << 8) | static_cast<unsigned char>(header[i]);
+          size = 0;
+          for (int i = 0; i < 4; ++i)
+            size = (size << 8) | static_cast<unsigned char>(header[8 + i]);
+        }
+
+        static
+        io_service&
+        service_of(std::vector<std::unique_ptr<socket>> const& sockets)
+        {
+          if (sockets.empty())
+            throw std::invalid_argument("striped stream without connections");
+          return sockets.front()->get_io_service();
+        }
+
+        striped_stream::striped_stream(
+          std::vector<std::unique_ptr<socket>> sockets,
+          std::size_t chunk_size)
+          : _service(service_of(sockets))
+          , _strand(_service)
+          , _chunk_size(std::min<std::size_t>(chunk_size, max_chunk_size))
+          , _send_sequence(0)
+          , _next_lane(0)
+          , _receiving(false)
+          , _receive_sequence(0)
+          , _ready_offset(0)
+          , _closed(0)
+        {
+          for (auto& sock: sockets)
+          {
+            std::unique_ptr<Lane> lane(new Lane);
+            lane->stream = std::move(sock);
+            lane->sequence = 0;
+            lane->paused = false;
+            lane->closed = false;
+            this->_lanes.push_back(std::move(lane));
+          }
+        }
+
+        io_service&
+        striped_stream::get_io_service()
+        {
+          return this->_service;
+        }
+
+        std::size_t
+        striped_stream::size() const
+        {
+          return this->_lanes.size();
+        }
+
+        void
+        striped_stream::async_close()
+        {
+          for (auto& lane: this->_lanes)
+            lane->stream->async_close();
+        }
+
+        void
+        striped_stream::_write_some(const_buffer buffer,
+                                    Completion const& completion)
+        {
+          this->_strand.dispatch([this, buffer, completion] ()
+          {
+            std::size_t size = buffer_size(buffer);
+            if (size == 0)
+              return completion(system::error_code(), 0);
+            auto data = buffer_cast<char const*>(buffer);
+            std::size_t chunks =
+              std::min(this->_lanes.size(),
+                       (size + this->_chunk_size - 1) / this->_chunk_size);
+            std::size_t total = std::min(size, chunks * this->_chunk_size);
+            ELLE_DEBUG("%s: send %s bytes in %s chunks", *this, total, chunks);
+            struct State
+            {
+              std::size_t left;
+              system::error_code error;
+            };
+            auto state = std::make_shared<State>(
+              State{chunks, system::error_code()});
+            Done done = [state, completion, total] (
+              system::error_code const& error)
+            {
+              if (error && !state->error)
+                state->error = error;
+              if (--state->left == 0)
+                completion(state->error, state->error ? 0 : total);
+            };
+            for (std::size_t i = 0; i < chunks; ++i)
+            {
+              auto& lane =
+                *this->_lanes[(this->_next_lane + i) % this->_lanes.size()];
+              std::size_t offset = i * this->_chunk_size;
+              std::size_t n = std::min(this->_chunk_size, size - offset);
+              encode_header(lane.out, this->_send_sequence++, n);
+              const_buffer payload(data + offset, n);
+              this->_write_all(
+                lane, const_buffer(lane.out, header_size),
+                [this, &lane, payload, done] (system::error_code const& error)
+                {
+                  if (error)
+                    return done(error);
+                  this->_write_all(lane, payload, done);
+                });
+            }
+            this->_next_lane = (this->_next_lane + chunks) % this->_lanes.size();
+          });
+        }
+
+        void
+        striped_stream::_write_all(Lane& lane, const_buffer buffer,
+                                   Done const& done)
+        {
+          lane.stream->async_write_some(
+            buffer,
+            this->_strand.wrap(
+              [this, &lane, buffer, done] (system::error_code const& error,
+                                           std::size_t size)
+              {
+                if (error || size == buffer_size(buffer))
+                  return done(error);
+                this->_write_all(lane, buffer + size, done);
+              }));
+        }
+
+        void
+        striped_stream::_read_some(mutable_buffer buffer,
+                                   Completion const& completion)
+        {
+          this->_strand.dispatch([this, buffer, completion] ()
+          {
+            this->_read_buffer = buffer;
+            this->_reader = completion;
+            // Start receiving on the first read, so write-only streams do
+            // not buffer anything.
+            if (!this->_receiving)
+            {
+              this->_receiving = true;
+              for (auto& lane: this->_lanes)
+                this->_receive(*lane);
+            }
+            this->_fill();
+          });
+        }
+
+        void
+        striped_stream::_read_all(Lane& lane, mutable_buffer buffer,
+                                  Done const& done)
+        {
+          lane.stream->async_read_some(
+            buffer,
+            this->_strand.wrap(
+              [this, &lane, buffer, done] (system::error_code const& error,
+                                           std::size_t size)
+              {
+                if (error || size == buffer_size(buffer))
+                  return done(error);
+                this->_read_all(lane, buffer + size, done);
+              }));
+        }
+
+        void
+        striped_stream::_receive(Lane& lane)
+        {
+          this->_read_all(
+            lane, mutable_buffer(lane.in, header_size),
+            [this, &lane] (system::error_code const& error)
+            {
+              if (error)
+                return this->_received(lane, error);
+              std::uint32_t size;
+              decode_header(lane.in, lane.sequence, size);
+              if (size == 0 || size > max_chunk_size)
+                return this->_received(lane,
+                                       boost::asio::error::message_size);
+              lane.chunk.resize(size);
+              this->_read_all(
+                lane, mutable_buffer(lane.chunk.data(), size),
+                [this, &lane] (system::error_code const& error)
+                {
+                  if (error == boost::asio::error::eof)
+                    this->_received(lane,
+                                    boost::asio::error::connection_aborted);
+                  else if (error)
+                    this->_received(lane, error);
+                  else
+                    this->_store(lane);
+                });
+            });
+        }
+
+        void
+        striped_stream::_received(Lane& lane, system::error_code const& error)
+        {
+          ELLE_TRACE("%s: connection closed: %s", *this, error.message());
+          lane.closed = true;
+          ++this->_closed;
+          if (error != boost::asio::error::eof && !this->_error)
+            this->_error = error;
+          this->_fill();
+        }
+
+        void
+        striped_stream::_store(Lane& lane)
+        {
+          ELLE_DEBUG("%s: received chunk %s of %s bytes",
+                     *this, lane.sequence, lane.chunk.size());
+          if (lane.sequence == this->_receive_sequence)
+          {
+            this->_ready.push_back(std::move(lane.chunk));
+            ++this->_receive_sequence;
+            for (auto it = this->_pending.begin();
+                 it != this->_pending.end() &&
+                   it->first == this->_receive_sequence;
+                 it = this->_pending.erase(it), ++this->_receive_sequence)
+              this->_ready.push_back(std::move(it->second));
+          }
+          else
+            this->_pending.insert(
+              std::make_pair(lane.sequence, std::move(lane.chunk)));
+          lane.chunk = std::vector<char>();
+          // Chunks of a connection arrive in order, so the connection
+          // carrying the missing chunk only paused on chunks already
+          // reassembled, and is resumed once they are consumed.
+          if (this->_ready.size() + this->_pending.size() >=
+              2 * this->_lanes.size())
+            lane.paused = true;
+          else
+            this->_receive(lane);
+          this->_fill();
+        }
+
+        void
+        striped_stream::_fill()
+        {
+          if (!this->_reader)
+            return;
+          std::size_t size = buffer_size(this->_read_buffer);
+          auto out = buffer_cast<char*>(this->_read_buffer);
+          std::size_t read = 0;
+          while (read < size && !this->_ready.empty())
+          {
+            auto& chunk = this->_ready.front();
+            auto n = std::min(size - read, chunk.size() - this->_ready_offset);
+            std::memcpy(out + read, chunk.data() + this->_ready_offset, n);
+            read += n;
+            this->_ready_offset += n;
+            if (this->_ready_offset == chunk.size())
+            {
+              this->_ready.pop_front();
+              this->_ready_offset = 0;
+            }
+          }
+          system::error_code error;
+          if (read == 0 && size != 0)
+          {
+            if (this->_error)
+              error = this->_error;
+            else if (this->_closed != this->_lanes.size())
+              return;
+            // Chunks left pending are missing a predecessor.
+            else if (this->_pending.empty())
+              error = boost::asio::error::eof;
+            else
+              error = boost::asio::error::connection_aborted;
+          }
+          auto reader = std::move(this->_reader);
+          this->_reader = Completion();
+          if (read)
+            for (auto& lane: this->_lanes)
+              if (lane->paused)
+              {
+                lane->paused = false;
+                this->_receive(*lane);
+              }
+          reader(error, read);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,127 @@
+#ifndef ASIO_UDT_STRIPED_STREAM_HH
+# define ASIO_UDT_STRIPED_STREAM_HH
+
+# include <cstdint>
+# include <deque>
+# include <functional>
+# include <map>
+# include <memory>
+# include <utility>
+# include <vector>
+
+# include <boost/asio.hpp>
+# include <boost/noncopyable.hpp>
+
+# include <asio-udt/fwd.hh>
+# include <asio-udt/socket.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Byte stream striped over several connections to the same peer.
+        ///
+        /// Writes are split in sequence-tagged chunks sent in parallel over
+        /// the connections, the peer striped_stream reassembles them in
+        /// order whatever connection they arrive on. Both sides must use
+        /// the same number of connections, in any order. Like sockets, at
+        /// most one read and one write may be pending at a time.
+        class striped_stream: public boost::noncopyable
+        {
+          public:
+            striped_stream(std::vector<std::unique_ptr<socket>> sockets,
+                           std::size_t chunk_size = 65536);
+
+          public:
+            io_service&
+            get_io_service();
+            /// Number of connections.
+            std::size_t
+            size() const;
+            /// Close all connections in the background.
+            void
+            async_close();
+
+          public:
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::size_t))
+            async_read_some(mutable_buffer buffer, Handler&& handler);
+            /// Send up to one chunk per connection of buffer.
+            template <typename Handler>
+            BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                          void (system::error_code,
+                                                std::size_t))
+            async_write_some(const_buffer buffer, Handler&& handler);
+
+          private:
+            typedef std::function<void (system::error_code const&,
+                                        std::size_t)> Completion;
+            typedef std::function<void (system::error_code const&)> Done;
+            struct _initiate_read_some;
+            struct _initiate_write_some;
+            void
+            _read_some(mutable_buffer buffer, Completion const& completion);
+            void
+            _write_some(const_buffer buffer, Completion const& completion);
+
+          private:
+            struct Lane
+            {
+              std::unique_ptr<socket> stream;
+              /// Header of the chunk being received.
+              char in[12];
+              /// Header of the chunk being sent.
+              char out[12];
+              std::uint64_t sequence;
+              std::vector<char> chunk;
+              bool paused;
+              bool closed;
+            };
+            /// Read, respectively write, exactly buffer on lane.
+            void
+            _read_all(Lane& lane, mutable_buffer buffer, Done const& done);
+            void
+            _write_all(Lane& lane, const_buffer buffer, Done const& done);
+            void
+            _receive(Lane& lane);
+            void
+            _received(Lane& lane, system::error_code const& error);
+            void
+            _store(Lane& lane);
+            /// Complete the pending read if possible.
+            void
+            _fill();
+
+          private:
+            io_service& _service;
+            io_service::strand _strand;
+            std::size_t _chunk_size;
+            std::vector<std::unique_ptr<Lane>> _lanes;
+            /// Sending side.
+            std::uint64_t _send_sequence;
+            std::size_t _next_lane;
+            /// Receiving side.
+            bool _receiving;
+            std::uint64_t _receive_sequence;
+            std::map<std::uint64_t, std::vector<char>> _pending;
+            std::deque<std::vector<char>> _ready;
+            std::size_t _ready_offset;
+            std::size_t _closed;
+            system::error_code _error;
+            mutable_buffer _read_buffer;
+            Completion _reader;
+        };
+      }
+    }
+  }
+}
+
+# include <asio-udt/striped-stream.hxx>
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef ASIO_UDT_STRIPED_STREAM_HXX
+# define ASIO_UDT_STRIPED_STREAM_HXX
+
+# include <memory>
+
+# include <boost/asio/async_result.hpp>
+# include <boost/asio/detail/bind_handler.hpp>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        struct striped_stream::_initiate_read_some
+        {
+          striped_stream* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler, mutable_buffer buffer) const
+          {
+            typedef typename std::decay<Handler>::type Completion;
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            auto& service = this->self->_service;
+            this->self->_read_some(
+              buffer,
+              [h, &service] (system::error_code const& error,
+                             std::size_t size)
+              {
+                asio::post(service,
+                           asio::detail::bind_handler(std::move(*h),
+                                                      error, size));
+              });
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, std::size_t))
+        striped_stream::async_read_some(mutable_buffer buffer,
+                                        Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, std::size_t)>(
+            _initiate_read_some{this}, handler, buffer);
+        }
+
+        struct striped_stream::_initiate_write_some
+        {
+          striped_stream* self;
+
+          template <typename Handler>
+          void
+          operator ()(Handler&& handler, const_buffer buffer) const
+          {
+            typedef typename std::decay<Handler>::type Completion;
+            auto h = std::make_shared<Completion>(
+              std::forward<Handler>(handler));
+            auto& service = this->self->_service;
+            this->self->_write_some(
+              buffer,
+              [h, &service] (system::error_code const& error,
+                             std::size_t size)
+              {
+                asio::post(service,
+                           asio::detail::bind_handler(std::move(*h),
+                                                      error, size));
+              });
+          }
+        };
+
+        template <typename Handler>
+        BOOST_ASIO_INITFN_RESULT_TYPE(Handler,
+                                      void (system::error_code, std::size_t))
+        striped_stream::async_write_some(const_buffer buffer,
+                                         Handler&& handler)
+        {
+          return async_initiate<Handler,
+                                void (system::error_code, std::size_t)>(
+            _initiate_write_some{this}, handler, buffer);
+        }
+      }
+    }
+  }
+}
+
+#endif
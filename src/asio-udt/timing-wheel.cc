@@ -0,0 +1,132 @@
+#include <asio-udt/timing-wheel.hh>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        timing_wheel::timing_wheel(Clock::duration resolution,
+                                   Clock::time_point now)
+          : _resolution(resolution)
+          , _origin(now)
+          , _current(0)
+        {}
+
+        timing_wheel::Tick
+        timing_wheel::_tick(Clock::time_point time) const
+        {
+          if (time <= this->_origin)
+            return 0;
+          return (time - this->_origin) / this->_resolution;
+        }
+
+        void
+        timing_wheel::add(Key key, Clock::time_point deadline)
+        {
+          // Round up so timers never expire early, and never in the current
+          // tick which was already processed.
+          Tick tick = this->_tick(deadline);
+          if (this->_origin + tick * this->_resolution < deadline)
+            ++tick;
+          if (tick <= this->_current)
+            tick = this->_current + 1;
+          this->_insert(key, tick);
+        }
+
+        void
+        timing_wheel::_insert(Key key, Tick deadline)
+        {
+          Tick delta = deadline - this->_current;
+          int level = 0;
+          while (level < levels - 1 && delta >= Tick(1) << (bits * (level + 1)))
+            ++level;
+          Tick at = deadline;
+          // Beyond the wheel range: park in the farthest slot, the timer is
+          // cascaded again when it is reached.
+          if (delta >= Tick(1) << (bits * levels))
+            at = this->_current + (Tick(slots - 1) << (bits * (levels - 1)));
+          int slot = (at >> (bits * level)) & (slots - 1);
+          this->_slots[level][slot].insert(key);
+          this->_timers[key] = timer{deadline, level, slot};
+        }
+
+        void
+        timing_wheel::remove(Key key)
+        {
+          auto it = this->_timers.find(key);
+          if (it == this->_timers.end())
+            return;
+          this->_slots[it->second.level][it->second.slot].erase(key);
+          this->_timers.erase(it);
+        }
+
+        void
+        timing_wheel::advance(Clock::time_point now, std::vector<Key>& expired)
+        {
+          Tick target = this->_tick(now);
+          while (this->_current < target)
+          {
+            if (this->_timers.empty())
+            {
+              this->_current = target;
+              break;
+            }
+            ++this->_current;
+            // Cascade coarser levels first, so timers they drop in finer
+            // levels are cascaded in turn.
+            int top = 0;
+            while (top < levels - 1 &&
+                   (this->_current &
+                    ((Tick(1) << (bits * (top + 1))) - 1)) == 0)
+              ++top;
+            for (int level = top; level > 0; --level)
+            {
+              std::unordered_set<Key> cascaded;
+              cascaded.swap(
+                this->_slots[level][(this->_current >> (bits * level)) &
+                                    (slots - 1)]);
+              for (auto key: cascaded)
+                this->_insert(key, this->_timers[key].deadline);
+            }
+            auto& slot = this->_slots[0][this->_current & (slots - 1)];
+            for (auto key: slot)
+            {
+              expired.push_back(key);
+              this->_timers.erase(key);
+            }
+            slot.clear();
+          }
+        }
+
+        timing_wheel::Clock::time_point
+        timing_wheel::next() const
+        {
+          if (this->_timers.empty())
+            return Clock::time_point::max();
+          // Past the next cascade, timers from coarser levels may be due.
+          Tick cascade = (this->_current | (slots - 1)) + 1;
+          Tick tick = this->_current + 1;
+          for (; tick < cascade; ++tick)
+            if (!this->_slots[0][tick & (slots - 1)].empty())
+              break;
+          return this->_origin + tick * this->_resolution;
+        }
+
+        bool
+        timing_wheel::empty() const
+        {
+          return this->_timers.empty();
+        }
+
+        std::size_t
+        timing_wheel::size() const
+        {
+          return this->_timers.size();
+        }
+      }
+    }
+  }
+}
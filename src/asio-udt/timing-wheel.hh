@@ -0,0 +1,84 @@
+#ifndef ASIO_UDT_TIMING_WHEEL_HH
+# define ASIO_UDT_TIMING_WHEEL_HH
+
+# include <chrono>
+# include <cstdint>
+# include <unordered_map>
+# include <unordered_set>
+# include <vector>
+
+namespace boost
+{
+  namespace asio
+  {
+    namespace ip
+    {
+      namespace udt
+      {
+        /// Hierarchical timing wheel.
+        ///
+        /// Timers are bucketed by tick in a few levels of slots, coarser
+        /// levels being cascaded into finer ones as time passes. Adding,
+        /// removing and expiring a timer are O(1), whatever the number of
+        /// timers.
+        class timing_wheel
+        {
+          public:
+            typedef std::uint64_t Key;
+            typedef std::chrono::steady_clock Clock;
+
+          public:
+            timing_wheel(Clock::duration resolution,
+                         Clock::time_point now = Clock::now());
+
+          public:
+            /// Arm timer key to expire at deadline. The key must not be
+            /// armed already.
+            void
+            add(Key key, Clock::time_point deadline);
+            /// Disarm timer key, if armed.
+            void
+            remove(Key key);
+            /// Advance the wheel up to now and append expired keys to
+            /// expired.
+            void
+            advance(Clock::time_point now, std::vector<Key>& expired);
+            /// Time at which advance must be called next: a timer may
+            /// expire then. Clock::time_point::max() if no timer is armed.
+            Clock::time_point
+            next() const;
+            bool
+            empty() const;
+            std::size_t
+            size() const;
+
+          private:
+            typedef std::uint64_t Tick;
+            static int const bits = 6;
+            static int const slots = 1 << bits;
+            static int const levels = 4;
+
+            Tick
+            _tick(Clock::time_point time) const;
+            void
+            _insert(Key key, Tick deadline);
+
+            struct timer
+            {
+              Tick deadline;
+              int level;
+              int slot;
+            };
+
+            Clock::duration _resolution;
+            Clock::time_point _origin;
+            Tick _current;
+            std::unordered_map<Key, timer> _timers;
+            std::unordered_set<Key> _slots[levels][slots];
+        };
+      }
+    }
+  }
+}
+
+#endif
@@ -1,8 +1,56 @@
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
 #include <boost/lexical_cast.hpp>
+#include <boost/thread.hpp>
 
 #include <asio-udt/acceptor.hh>
+#include <asio-udt/broadcast.hh>
+#include <asio-udt/buffer-pool.hh>
+#include <asio-udt/checksum.hh>
+#ifdef ASIO_UDT_LZ4
+# include <asio-udt/compressed-stream.hh>
+#endif
+#include <asio-udt/connection-pool.hh>
+#include <asio-udt/dispatcher.hh>
+#include <asio-udt/file-transfer.hh>
+#include <asio-udt/framed-socket.hh>
+#include <asio-udt/recorder.hh>
+#include <asio-udt/replay.hh>
 #include <asio-udt/service.hh>
 #include <asio-udt/socket.hh>
+#include <asio-udt/statistics.hh>
+#include <asio-udt/striped-stream.hh>
+#include <asio-udt/timing-wheel.hh>
+
+namespace udt = boost::asio::ip::udt;
+
+/// Abort on failure, NDEBUG or not.
+#define CHECK(Condition)                                                \
+  do                                                                    \
+    if (!(Condition))                                                   \
+    {                                                                   \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: "    \
+                << #Condition << std::endl;                             \
+      std::abort();                                                     \
+    }                                                                   \
+  while (false)
 
 static const size_t buffer_size = 128;
 
@@ -210,13 +258,1634 @@ class EchoClient
 //   s->async_read_some(boost::asio::buffer(buf, sizeof(buf)), ignore);
 // }
 
+static
+void
+test_timing_wheel()
+{
+  typedef udt::timing_wheel::Clock Clock;
+  auto origin = Clock::now();
+  auto ms = [origin] (double n)
+    {
+      return origin + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(n));
+    };
+  udt::timing_wheel wheel(std::chrono::milliseconds(1), origin);
+  // Deadlines within each level, past the wheel range, and between ticks.
+  std::vector<std::pair<udt::timing_wheel::Key, double>> timers{
+    {1, 1.5}, {2, 63}, {3, 64}, {4, 100}, {5, 4096}, {6, 5000},
+    {7, 262144}, {8, 300000}, {9, 17000000}};
+  for (auto const& t: timers)
+    wheel.add(t.first, ms(t.second));
+  wheel.add(10, ms(80));
+  wheel.remove(10);
+  CHECK(wheel.size() == timers.size());
+  std::vector<udt::timing_wheel::Key> expired;
+  for (auto const& t: timers)
+  {
+    // Timers never expire early, nor later than the next tick.
+    auto due = static_cast<std::int64_t>(std::ceil(t.second));
+    CHECK(wheel.next() <= ms(due));
+    wheel.advance(ms(due - 1), expired);
+    CHECK(expired.empty());
+    wheel.advance(ms(due), expired);
+    CHECK(expired == std::vector<udt::timing_wheel::Key>{t.first});
+    expired.clear();
+  }
+  CHECK(wheel.empty());
+  CHECK(wheel.next() == Clock::time_point::max());
+}
+
+static
+void
+test_buffer_pool()
+{
+  udt::buffer_pool::slab kept;
+  {
+    udt::buffer_pool pool(64, 2);
+    CHECK(pool.in_use() == 0);
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    CHECK(a && b && a.capacity() == 64 && a.data() != b.data());
+    CHECK(!pool.acquire());
+    CHECK(pool.exhaustions() == 1);
+    // Slabs come back once their last copy is gone.
+    auto released = a.data();
+    auto copy = a;
+    a.release();
+    CHECK(pool.in_use() == 2);
+    copy.release();
+    CHECK(pool.in_use() == 1);
+    auto c = pool.acquire();
+    // Most recently released first.
+    CHECK(c.data() == released);
+    kept = std::move(b);
+    CHECK(!b && pool.in_use() == 2);
+  }
+  // The pool memory outlives the pool while slabs are held.
+  kept.data()[63] = 1;
+  kept.release();
+  CHECK(!kept);
+}
+
+static
+void
+test_histogram()
+{
+  auto before = udt::statistics::snapshot().sent;
+  udt::instrument::sent(0);
+  udt::instrument::sent(1);
+  udt::instrument::sent(1000);
+  udt::instrument::sent(~std::size_t(0));
+  auto sent = udt::statistics::snapshot().sent;
+  CHECK(sent.count() - before.count() == 4);
+  CHECK(sent.counts[0] - before.counts[0] == 1);
+  CHECK(sent.counts[1] - before.counts[1] == 1);
+  CHECK(sent.counts[10] - before.counts[10] == 1);
+  CHECK(sent.counts[64] - before.counts[64] == 1);
+  udt::histogram h;
+  h.counts[0] = 1;
+  h.counts[3] = 2;
+  h.counts[64] = 1;
+  CHECK(h.percentile(0) == 0);
+  CHECK(h.percentile(0.5) == 7);
+  CHECK(h.percentile(1) == ~std::uint64_t(0));
+  udt::statistics::enable(false);
+  udt::instrument::sent(1);
+  CHECK(udt::statistics::snapshot().sent.count() == sent.count());
+  udt::statistics::enable(true);
+}
+
+static
+void
+test_crc32c()
+{
+  char const* check = "123456789";
+  CHECK(udt::crc32c(check, 9) == 0xe3069283);
+  CHECK(udt::crc32c_portable(check, 9) == 0xe3069283);
+  std::vector<unsigned char> data(4096 + 16);
+  for (std::size_t i = 0; i < data.size(); ++i)
+    data[i] = (i * 2654435761u) >> 13;
+  // Every alignment and tail length, chained or not, agrees with the
+  // portable implementation.
+  for (std::size_t offset = 0; offset < 16; ++offset)
+    for (std::size_t size: {0, 1, 3, 7, 8, 9, 15, 64, 1000, 4096})
+    {
+      auto p = data.data() + offset;
+      auto crc = udt::crc32c(p, size);
+      CHECK(crc == udt::crc32c_portable(p, size));
+      auto half = size / 2;
+      CHECK(udt::crc32c(p + half, size - half, udt::crc32c(p, half)) == crc);
+    }
+}
+
+static
+void
+test_recorder()
+{
+  udt::recorder recorder(5);
+  CHECK(recorder.capacity() == 8);
+  for (int i = 0; i < 10; ++i)
+    recorder.record(udt::recorder::registration, udt::recorder::write, i,
+                    i + 1, -1);
+  CHECK(recorder.recorded() == 10);
+  auto events = recorder.events();
+  // The ring keeps the last events, oldest first.
+  CHECK(events.size() == 8);
+  for (std::size_t i = 0; i < events.size(); ++i)
+  {
+    CHECK(events[i].fd == int(i + 2));
+    CHECK(events[i].operation == i + 3);
+    CHECK(events[i].kind == udt::recorder::registration);
+    CHECK(events[i].queue == udt::recorder::write);
+    CHECK(i == 0 || events[i].time >= events[i - 1].time);
+  }
+  char path[] = "/tmp/asio-udt-test-XXXXXX";
+  int fd = ::mkstemp(path);
+  CHECK(fd != -1);
+  ::close(fd);
+  recorder.save(path);
+  auto loaded = udt::recorder::load(path);
+  CHECK(loaded.size() == events.size());
+  for (std::size_t i = 0; i < events.size(); ++i)
+  {
+    CHECK(loaded[i].time == events[i].time);
+    CHECK(loaded[i].operation == events[i].operation);
+    CHECK(loaded[i].fd == events[i].fd);
+    CHECK(loaded[i].value == -1);
+  }
+  // Anything else is rejected.
+  {
+    std::FILE* f = std::fopen(path, "w");
+    std::fputs("not a trace", f);
+    std::fclose(f);
+  }
+  bool rejected = false;
+  try
+  {
+    udt::recorder::load(path);
+  }
+  catch (boost::system::system_error const&)
+  {
+    rejected = true;
+  }
+  CHECK(rejected);
+  std::remove(path);
+}
+
+static
+void
+test_replay()
+{
+  typedef udt::recorder r;
+  auto ms = [] (std::uint64_t n) { return n * 1000000; };
+  std::vector<r::event> events = {
+    // A read served, with a recorded expiry of no consequence.
+    {ms(0), 1, 7, 100, r::registration, r::read, 0},
+    {ms(50), 0, -1, 1, r::wakeup, r::read, 0},
+    {ms(50), 0, 7, 0, r::ready, r::read, 0},
+    // A ready fd without operation.
+    {ms(55), 0, -1, 1, r::wakeup, r::read, 0},
+    {ms(55), 0, 9, 0, r::ready, r::read, 0},
+    // A write times out by the trace clock, though its expiry is not in
+    // the trace and replaying takes less than its timeout.
+    {ms(60), 2, 8, 10, r::registration, r::write, 0},
+    {ms(65), 0, -1, 0, r::wakeup, r::read, 0},
+    {ms(1000), 0, -1, 0, r::wakeup, r::read, 0},
+    // A cancelled read.
+    {ms(1010), 3, 7, -1, r::registration, r::read, 0},
+    {ms(1020), 3, 7, 0, r::cancellation, r::read, 0},
+  };
+  auto res = udt::replay(events).run();
+  CHECK(res.registrations == 3);
+  CHECK(res.cancellations == 1);
+  CHECK(res.wakeups == 4);
+  CHECK(res.ready == 2);
+  CHECK(res.lost == 1);
+}
+
+typedef std::unique_ptr<udt::socket> Socket;
+
+static
+boost::asio::ip::udp::endpoint
+loopback(int port)
+{
+  return boost::asio::ip::udp::endpoint(
+    boost::asio::ip::address_v4::loopback(), port);
+}
+
+/// Connect a client to a server socket over the loopback.
+static
+std::pair<Socket, Socket>
+connect_pair(boost::asio::io_service& io_service, int port)
+{
+  udt::acceptor acceptor(io_service, port);
+  Socket client(new udt::socket(io_service));
+  Socket server;
+  acceptor.async_accept(
+    [&] (boost::system::error_code const& error, udt::socket* socket)
+    {
+      CHECK(!error);
+      server.reset(socket);
+    });
+  client->async_connect(loopback(port),
+                        [] (boost::system::error_code const& error)
+                        {
+                          CHECK(!error);
+                        });
+  io_service.run();
+  io_service.restart();
+  CHECK(server);
+  return std::make_pair(std::move(client), std::move(server));
+}
+
+static
+std::string
+pattern(std::size_t size)
+{
+  std::string res(size, 0);
+  for (std::size_t i = 0; i < size; ++i)
+    res[i] = (i * 2654435761u) >> 13;
+  return res;
+}
+
+/// Write all of data, then call done.
+template <typename Stream>
+static
+void
+write_all(Stream& stream, std::string const& data,
+          std::function<void ()> const& done, std::size_t offset = 0)
+{
+  if (offset == data.size())
+    return done();
+  stream.async_write_some(
+    boost::asio::buffer(data.data() + offset, data.size() - offset),
+    [&stream, &data, done, offset] (boost::system::error_code const& error,
+                                    std::size_t size)
+    {
+      CHECK(!error);
+      write_all(stream, data, done, offset + size);
+    });
+}
+
+/// Fill data, then call done.
+template <typename Stream>
+static
+void
+read_all(Stream& stream, std::string& data,
+         std::function<void ()> const& done, std::size_t offset = 0)
+{
+  if (offset == data.size())
+    return done();
+  stream.async_read_some(
+    boost::asio::buffer(&data[offset], data.size() - offset),
+    [&stream, &data, done, offset] (boost::system::error_code const& error,
+                                    std::size_t size)
+    {
+      CHECK(!error);
+      read_all(stream, data, done, offset + size);
+    });
+}
+
+static
+void
+test_shutdown(boost::asio::io_service& io_service)
+{
+  auto peers = connect_pair(io_service, 4300);
+  auto& client = *peers.first;
+  auto& server = *peers.second;
+  auto sent = pattern(1 << 20);
+  std::string received(sent.size(), 0);
+  bool drained = false;
+  char c = 0;
+  write_all(client, sent, [&]
+    {
+      client.async_shutdown(
+        udt::socket::shutdown_send,
+        [&] (boost::system::error_code const& error)
+        {
+          CHECK(!error);
+          // Everything was acknowledged by the peer.
+          CHECK(client.backlog() == 0);
+          drained = true;
+          client.async_write_some(
+            boost::asio::buffer(&c, 1),
+            [] (boost::system::error_code const& error, std::size_t)
+            {
+              CHECK(error == boost::asio::error::shut_down);
+            });
+        });
+    });
+  read_all(server, received, [] {});
+  io_service.run();
+  io_service.restart();
+  CHECK(drained);
+  CHECK(received == sent);
+  // Once receiving is shut down, reads end right away.
+  bool eof = false;
+  server.async_shutdown(
+    udt::socket::shutdown_receive,
+    [&] (boost::system::error_code const& error)
+    {
+      CHECK(!error);
+      server.async_read_some(
+        boost::asio::buffer(&c, 1),
+        [&] (boost::system::error_code const& error, std::size_t)
+        {
+          CHECK(error == boost::asio::error::eof);
+          eof = true;
+        });
+    });
+  io_service.run();
+  io_service.restart();
+  CHECK(eof);
+}
+
+static
+void
+test_cancel(boost::asio::io_service& io_service)
+{
+  auto peers = connect_pair(io_service, 4301);
+  auto& client = *peers.first;
+  auto& server = *peers.second;
+  char buffer[16];
+  boost::system::error_code aborted;
+  server.async_read_some(
+    boost::asio::buffer(buffer),
+    [&] (boost::system::error_code const& error, std::size_t)
+    {
+      aborted = error;
+    });
+  auto operation = server.read_operation();
+  CHECK(operation != 0);
+  // Canceling writes leaves reads alone.
+  server.cancel_write();
+  server.cancel_read(operation);
+  io_service.run();
+  io_service.restart();
+  CHECK(aborted == boost::asio::error::operation_aborted);
+  // A stale identifier does not cancel the read that followed.
+  std::size_t read = 0;
+  server.async_read_some(
+    boost::asio::buffer(buffer),
+    [&] (boost::system::error_code const& error, std::size_t size)
+    {
+      CHECK(!error);
+      read = size;
+    });
+  CHECK(server.read_operation() != operation);
+  server.cancel_read(operation);
+  client.async_write_some(
+    boost::asio::buffer("x", 1),
+    [] (boost::system::error_code const& error, std::size_t)
+    {
+      CHECK(!error);
+    });
+  io_service.run();
+  io_service.restart();
+  CHECK(read == 1 && buffer[0] == 'x');
+  // A pending connection is aborted once, and the socket can connect
+  // again.
+  udt::socket socket(io_service);
+  int aborts = 0;
+  socket.async_connect(
+    loopback(4399),
+    [&] (boost::system::error_code const& error)
+    {
+      CHECK(error == boost::asio::error::operation_aborted);
+      ++aborts;
+    });
+  socket.cancel();
+  io_service.run();
+  io_service.restart();
+  CHECK(aborts == 1);
+  udt::acceptor acceptor(io_service, 4302);
+  Socket accepted;
+  acceptor.async_accept(
+    [&] (boost::system::error_code const& error, udt::socket* peer)
+    {
+      CHECK(!error);
+      accepted.reset(peer);
+    });
+  bool connected = false;
+  socket.async_connect(loopback(4302),
+                       [&] (boost::system::error_code const& error)
+                       {
+                         CHECK(!error);
+                         connected = true;
+                       });
+  io_service.run();
+  io_service.restart();
+  CHECK(connected && accepted);
+  // Options apply to the fresh UDT socket too: without address reuse,
+  // binding the port of the acceptor fails.
+  udt::socket exclusive(io_service);
+  exclusive.set_option(udt::reuseaddr(false));
+  exclusive.async_connect(
+    loopback(4399),
+    [&] (boost::system::error_code const& error)
+    {
+      CHECK(error == boost::asio::error::operation_aborted);
+      ++aborts;
+    });
+  exclusive.cancel();
+  io_service.run();
+  io_service.restart();
+  CHECK(aborts == 2);
+  boost::system::error_code error;
+  exclusive.bind(4302, error);
+  CHECK(error);
+}
+
+static
+void
+test_accept_into(boost::asio::io_service& io_service)
+{
+  udt::acceptor acceptor(io_service, 4303);
+  udt::socket server(io_service);
+  udt::socket client(io_service);
+  bool accepted = false;
+  acceptor.async_accept(server,
+                        [&] (boost::system::error_code const& error)
+                        {
+                          CHECK(!error);
+                          accepted = true;
+                        });
+  client.async_connect(loopback(4303),
+                       [] (boost::system::error_code const& error)
+                       {
+                         CHECK(!error);
+                       });
+  io_service.run();
+  io_service.restart();
+  CHECK(accepted);
+  CHECK(server.remote_endpoint().address().is_loopback());
+  // Connected sockets cannot be accepted into.
+  boost::system::error_code open;
+  acceptor.async_accept(server,
+                        [&] (boost::system::error_code const& error)
+                        {
+                          open = error;
+                        });
+  io_service.run();
+  io_service.restart();
+  CHECK(open == boost::asio::error::already_open);
+  // Queued sends move along with the socket, by construction or
+  // assignment.
+  std::size_t sent = 0;
+  auto count = [&] (boost::system::error_code const& error, std::size_t size)
+    {
+      CHECK(!error);
+      sent += size;
+    };
+  client.async_send(boost::asio::buffer("hello ", 6), count);
+  udt::socket moved(std::move(client));
+  moved.async_send(boost::asio::buffer("world", 5), count);
+  udt::socket assigned(io_service);
+  assigned = std::move(moved);
+  assigned.async_send(boost::asio::buffer("!", 1), count);
+  std::string received(12, 0);
+  read_all(server, received, [] {});
+  io_service.run();
+  io_service.restart();
+  CHECK(sent == 12);
+  CHECK(received == "hello world!");
+}
+
+static
+void
+test_striped(boost::asio::io_service& io_service)
+{
+  std::vector<Socket> clients;
+  std::vector<Socket> servers;
+  for (int port = 4304; port < 4308; ++port)
+  {
+    auto peers = connect_pair(io_service, port);
+    clients.push_back(std::move(peers.first));
+    // Connections are paired in any order.
+    servers.insert(servers.begin(), std::move(peers.second));
+  }
+  // Small chunks, so each write is spread over every connection and
+  // chunks arrive out of order.
+  udt::striped_stream client(std::move(clients), 1000);
+  udt::striped_stream server(std::move(servers), 1000);
+  CHECK(client.size() == 4 && server.size() == 4);
+  auto sent = pattern(1 << 20);
+  std::string received(sent.size(), 0);
+  // Connections keep receiving: close them once done.
+  int done = 0;
+  auto close = [&]
+    {
+      if (++done < 2)
+        return;
+      client.async_close();
+      server.async_close();
+    };
+  write_all(client, sent, close);
+  read_all(server, received, close);
+  io_service.run();
+  io_service.restart();
+  CHECK(received == sent);
+}
+
+static
+void
+test_send(boost::asio::io_service& io_service)
+{
+  auto peers = connect_pair(io_service, 4308);
+  auto& client = *peers.first;
+  auto& server = *peers.second;
+  // A second pending read is rejected, the first one remains.
+  char c = 0;
+  bool read = false;
+  boost::system::error_code started;
+  server.async_read_some(
+    boost::asio::buffer(&c, 1),
+    [&] (boost::system::error_code const& error, std::size_t size)
+    {
+      CHECK(!error && size == 1);
+      read = true;
+    });
+  server.async_read_some(
+    boost::asio::buffer(&c, 1),
+    [&] (boost::system::error_code const& error, std::size_t)
+    {
+      started = error;
+    });
+  client.async_send(boost::asio::buffer("x", 1),
+                    [] (boost::system::error_code const& error, std::size_t)
+                    {
+                      CHECK(!error);
+                    });
+  io_service.run();
+  io_service.restart();
+  CHECK(started == boost::asio::error::already_started);
+  CHECK(read && c == 'x');
+  // Sends are copied, and written and completed in order.
+  std::string sent;
+  int completed = 0;
+  for (int i = 0; i < 64; ++i)
+  {
+    std::string chunk = pattern(4096 + i);
+    sent += chunk;
+    client.async_send(
+      boost::asio::buffer(chunk),
+      [&, i] (boost::system::error_code const& error, std::size_t size)
+      {
+        CHECK(!error);
+        CHECK(size == std::size_t(4096 + i));
+        CHECK(completed == i);
+        ++completed;
+      });
+  }
+  std::string received(sent.size(), 0);
+  read_all(server, received, [] {});
+  io_service.run();
+  io_service.restart();
+  CHECK(completed == 64);
+  CHECK(received == sent);
+}
+
+#ifdef ASIO_UDT_LZ4
+static
+void
+test_compressed(boost::asio::io_service& io_service)
+{
+  auto peers = connect_pair(io_service, 4309);
+  // Compress on the same io_service: the test is single threaded.
+  udt::compressed_stream client(*peers.first, io_service);
+  udt::compressed_stream server(*peers.second, io_service);
+  // Compressible text, then data that does not compress.
+  std::string sent;
+  while (sent.size() < 512 * 1024)
+    sent += "The bind method is usually to assign a UDT socket a local "
+      "address, including IP address and port number. ";
+  auto text = sent.size();
+  sent += pattern(256 * 1024);
+  std::string received(sent.size(), 0);
+  write_all(client, sent, [] {});
+  read_all(server, received, [] {});
+  io_service.run();
+  io_service.restart();
+  CHECK(received == sent);
+  CHECK(client.raw_bytes() == sent.size());
+  CHECK(client.wire_bytes() < client.raw_bytes() - text / 2);
+}
+#endif
+
+/// Read and check frames from index on.
+static
+void
+read_frames(udt::framed_socket& framed, std::vector<std::string> const& frames,
+            std::size_t index = 0)
+{
+  if (index == frames.size())
+    return;
+  framed.async_read_frame(
+    [&framed, &frames, index] (boost::system::error_code const& error,
+                               boost::asio::const_buffer frame)
+    {
+      CHECK(!error);
+      CHECK(std::string(boost::asio::buffer_cast<char const*>(frame),
+                         boost::asio::buffer_size(frame)) == frames[index]);
+      read_frames(framed, frames, index + 1);
+    });
+}
+
+static
+void
+test_framed(boost::asio::io_service& io_service)
+{
+  auto peers = connect_pair(io_service, 4310);
+  // A small ring, so some frames do not fit.
+  udt::framed_socket client(*peers.first, 64 * 1024);
+  udt::framed_socket server(*peers.second, 64 * 1024);
+  std::vector<std::string> frames;
+  for (std::size_t size: {0, 1, 100, 1000, 300000, 5, 65536, 3})
+    frames.push_back(pattern(size));
+  std::size_t sent = 0;
+  for (auto const& frame: frames)
+    client.async_write_frame(
+      boost::asio::buffer(frame),
+      [&sent, &frame] (boost::system::error_code const& error,
+                       std::size_t size)
+      {
+        CHECK(!error);
+        CHECK(size == frame.size());
+        ++sent;
+      });
+  read_frames(server, frames);
+  io_service.run();
+  io_service.restart();
+  CHECK(sent == frames.size());
+  CHECK(server.buffered() == 0);
+  // Owned frames are moved in, in order with borrowed ones.
+  sent = 0;
+  for (std::size_t i = 0; i < frames.size(); ++i)
+  {
+    auto callback = [&sent, &frames, i] (boost::system::error_code const& e,
+                                         std::size_t size)
+    {
+      CHECK(!e);
+      CHECK(size == frames[i].size());
+      ++sent;
+    };
+    if (i % 2)
+      client.async_write_frame(boost::asio::buffer(frames[i]), callback);
+    else
+      client.async_write_frame(
+        std::vector<char>(frames[i].begin(), frames[i].end()), callback);
+  }
+  read_frames(server, frames);
+  io_service.run();
+  io_service.restart();
+  CHECK(sent == frames.size());
+  CHECK(server.buffered() == 0);
+  // Frames must fit the 32-bit header. The buffer is never read.
+  if (sizeof(std::size_t) > 4)
+  {
+    boost::system::error_code rejected;
+    client.async_write_frame(
+      boost::asio::const_buffer(frames[1].data(),
+                                std::size_t(0xffffffff) + 1),
+      [&] (boost::system::error_code const& error, std::size_t)
+      {
+        rejected = error;
+      });
+    io_service.run();
+    io_service.restart();
+    CHECK(rejected == boost::asio::error::message_size);
+  }
+}
+
+static
+void
+test_autotune(boost::asio::io_service& io_service)
+{
+  auto& service = boost::asio::use_service<udt::service>(io_service);
+  // Room for one tuned connection at most.
+  std::size_t memory = 384 * 1024;
+  service.autotune(memory);
+  std::vector<std::pair<Socket, Socket>> connections;
+  for (int port = 4311; port < 4315; ++port)
+  {
+    connections.push_back(connect_pair(io_service, port));
+    CHECK(service.autotuned() > 0);
+    CHECK(service.autotuned() <= memory);
+  }
+  connections.clear();
+  io_service.run();
+  io_service.restart();
+  CHECK(service.autotuned() == 0);
+  service.autotune(0);
+}
+
+static
+void
+test_polled()
+{
+  boost::asio::io_service io_service;
+  boost::asio::add_service(
+    io_service, new udt::service(io_service, udt::service::polled));
+  auto peers = connect_pair(io_service, 4315);
+  auto& client = *peers.first;
+  auto& server = *peers.second;
+  char c = 0;
+  bool read = false;
+  server.async_read_some(
+    boost::asio::buffer(&c, 1),
+    [&] (boost::system::error_code const& error, std::size_t size)
+    {
+      CHECK(!error && size == 1);
+      read = true;
+    });
+  // A pending read with nothing to read does not spin the thread.
+  auto cpu = std::clock();
+  io_service.run_for(std::chrono::milliseconds(200));
+  CHECK(!read);
+  CHECK(std::clock() - cpu < CLOCKS_PER_SEC / 20);
+  client.async_write_some(
+    boost::asio::buffer("x", 1),
+    [] (boost::system::error_code const& error, std::size_t)
+    {
+      CHECK(!error);
+    });
+  // Returns once nothing is pending anymore.
+  io_service.run();
+  CHECK(read && c == 'x');
+}
+
+static
+void
+test_shared()
+{
+  auto& dispatcher = udt::dispatcher::instance();
+  boost::asio::io_service first;
+  boost::asio::add_service(
+    first, new udt::service(first, udt::service::shared));
+  boost::asio::io_service second;
+  boost::asio::add_service(
+    second, new udt::service(second, udt::service::shared));
+  // The reactor starts with the first operation.
+  CHECK(!dispatcher.running());
+  auto one = connect_pair(first, 4316);
+  CHECK(dispatcher.running());
+  auto two = connect_pair(second, 4317);
+  // Each service gets the events of its own sockets only.
+  auto sent = pattern(256 * 1024);
+  std::string received_one(sent.size(), 0);
+  std::string received_two(sent.size(), 0);
+  write_all(*one.first, sent, [] {});
+  read_all(*one.second, received_one, [] {});
+  write_all(*two.first, sent, [] {});
+  read_all(*two.second, received_two, [] {});
+  boost::thread thread([&] { second.run(); });
+  first.run();
+  thread.join();
+  CHECK(received_one == sent);
+  CHECK(received_two == sent);
+}
+
+static
+std::string
+temporary()
+{
+  char path[] = "/tmp/asio-udt-test-XXXXXX";
+  int fd = ::mkstemp(path);
+  CHECK(fd != -1);
+  ::close(fd);
+  return path;
+}
+
+static
+void
+write_file(std::string const& path, std::string const& data)
+{
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(data.data(), data.size());
+  CHECK(file);
+}
+
+static
+std::string
+read_file(std::string const& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+/// Transfer source to destination, returning the bytes the receiver
+/// already had.
+static
+std::uint64_t
+transfer(boost::asio::io_service& io_service,
+         udt::socket& client, udt::socket& server,
+         std::string const& source, std::string const& destination)
+{
+  udt::file_transfer sender(client, io_service, source, 64 * 1024);
+  udt::file_transfer receiver(server, io_service, destination);
+  bool sent = false;
+  bool received = false;
+  sender.async_send(
+    [&] (boost::system::error_code const& error, std::uint64_t)
+    {
+      CHECK(!error);
+      sent = true;
+    });
+  receiver.async_receive(
+    [&] (boost::system::error_code const& error, std::uint64_t)
+    {
+      CHECK(!error);
+      received = true;
+    });
+  io_service.run();
+  io_service.restart();
+  CHECK(sent && received);
+  CHECK(read_file(destination) == read_file(source));
+  CHECK(sender.skipped() == receiver.skipped());
+  return receiver.skipped();
+}
+
+static
+void
+test_file_transfer(boost::asio::io_service& io_service)
+{
+  auto peers = connect_pair(io_service, 4318);
+  auto& client = *peers.first;
+  auto& server = *peers.second;
+  std::uint64_t chunk = 64 * 1024;
+  auto source = temporary();
+  auto destination = temporary();
+  auto data = pattern(5 * chunk + 1000);
+  write_file(source, data);
+  CHECK(transfer(io_service, client, server, source, destination) == 0);
+  // An interrupted transfer resumes from the first missing chunk.
+  write_file(destination, data.substr(0, 2 * chunk + chunk / 2));
+  CHECK(transfer(io_service, client, server, source, destination) ==
+        2 * chunk);
+  // A corrupted copy is fixed from the first corrupted chunk on.
+  auto corrupted = data;
+  corrupted[chunk + 10] ^= 1;
+  write_file(destination, corrupted);
+  CHECK(transfer(io_service, client, server, source, destination) == chunk);
+  // A longer copy is truncated.
+  write_file(destination, data + "trailing");
+  CHECK(transfer(io_service, client, server, source, destination) ==
+        data.size());
+  // Manifests are checked before being trusted.
+  auto manifest = [&] (std::uint64_t size, std::uint32_t chunk,
+                       std::uint32_t count)
+    {
+      std::string header(16, 0);
+      for (int i = 0; i < 8; ++i)
+        header[i] = size >> (56 - 8 * i);
+      for (int i = 0; i < 4; ++i)
+      {
+        header[8 + i] = chunk >> (24 - 8 * i);
+        header[12 + i] = count >> (24 - 8 * i);
+      }
+      udt::file_transfer receiver(server, io_service, destination);
+      boost::system::error_code res;
+      receiver.async_receive(
+        [&] (boost::system::error_code const& error, std::uint64_t)
+        {
+          res = error;
+        });
+      write_all(client, header, [] {});
+      std::string request(4, 0);
+      // Valid manifests are answered with the first chunk needed.
+      if (size == 0)
+        read_all(client, request, [] {});
+      io_service.run();
+      io_service.restart();
+      return res;
+    };
+  // Chunks smaller than the request.
+  CHECK(!manifest(0, 1, 0));
+  CHECK(read_file(destination).empty());
+  // Chunk count overflow.
+  CHECK(manifest(~std::uint64_t(0), 1, 0) ==
+        boost::system::errc::bad_message);
+  // Senders do not announce chunks receivers reject.
+  udt::file_transfer sender(client, io_service, source, 1ul << 32);
+  boost::system::error_code invalid;
+  sender.async_send(
+    [&] (boost::system::error_code const& error, std::uint64_t)
+    {
+      invalid = error;
+    });
+  io_service.run();
+  io_service.restart();
+  CHECK(invalid == boost::system::errc::invalid_argument);
+  std::remove(source.c_str());
+  std::remove(destination.c_str());
+}
+
+/// Reactor actions queued for a socket follow it when it is moved, and
+/// abort once it is gone.
+static
+void
+test_anchor(boost::asio::io_service& io_service)
+{
+  auto peers = connect_pair(io_service, 4319);
+  std::string data = pattern(4);
+  std::string received(data.size(), 0);
+  int calls = 0;
+  peers.first->async_read_some(
+    boost::asio::buffer(&received[0], received.size()),
+    [&] (boost::system::error_code const& error, std::size_t size)
+    {
+      CHECK(!error);
+      CHECK(size == data.size());
+      ++calls;
+    });
+  peers.second->async_write_some(
+    boost::asio::buffer(data),
+    [] (boost::system::error_code const& error, std::size_t)
+    {
+      CHECK(!error);
+    });
+  // Let the reactor queue the read action, then move the socket.
+  boost::this_thread::sleep_for(boost::chrono::milliseconds(200));
+  Socket moved(new udt::socket(std::move(*peers.first)));
+  io_service.run();
+  io_service.restart();
+  CHECK(calls == 1);
+  CHECK(received == data);
+  moved->async_read_some(
+    boost::asio::buffer(&received[0], received.size()),
+    [&] (boost::system::error_code const& error, std::size_t size)
+    {
+      CHECK(error == boost::asio::error::operation_aborted);
+      CHECK(size == 0);
+      ++calls;
+    });
+  peers.second->async_write_some(
+    boost::asio::buffer(data),
+    [] (boost::system::error_code const&, std::size_t)
+    {});
+  boost::this_thread::sleep_for(boost::chrono::milliseconds(200));
+  moved.reset();
+  io_service.run();
+  io_service.restart();
+  CHECK(calls == 2);
+}
+
+static
+void
+test_connection_pool(boost::asio::io_service& io_service)
+{
+  udt::acceptor acceptor(io_service, 4320);
+  auto peer = loopback(4320);
+  // Get a fresh connection from pool.
+  auto connect = [&] (udt::connection_pool& pool, Socket& client,
+                      Socket& server)
+    {
+      acceptor.async_accept(
+        [&] (boost::system::error_code const& error, udt::socket* socket)
+        {
+          CHECK(!error);
+          server.reset(socket);
+        });
+      pool.async_get(peer,
+                     [&] (boost::system::error_code const& error,
+                          udt::socket* socket)
+                     {
+                       CHECK(!error);
+                       client.reset(socket);
+                     });
+      io_service.run();
+      io_service.restart();
+      CHECK(client && server);
+    };
+  udt::connection_pool pool(io_service, 1,
+                            boost::posix_time::milliseconds(300));
+  Socket client;
+  Socket server;
+  connect(pool, client, server);
+  // Released connections are reused.
+  auto reused = client.get();
+  pool.release(client.release());
+  CHECK(pool.idle() == 1);
+  pool.async_get(peer,
+                 [&] (boost::system::error_code const& error,
+                      udt::socket* socket)
+                 {
+                   CHECK(!error);
+                   CHECK(socket == reused);
+                   client.reset(socket);
+                 });
+  io_service.run();
+  io_service.restart();
+  CHECK(client && pool.idle() == 0);
+  // Idle connections are closed once expired, without another request.
+  pool.release(client.release());
+  CHECK(pool.idle() == 1);
+  io_service.run();
+  io_service.restart();
+  CHECK(pool.idle() == 0);
+  // Pools that keep nothing close released connections right away.
+  connect(pool, client, server);
+  udt::connection_pool none(io_service, 0);
+  none.release(client.release());
+  CHECK(none.idle() == 0);
+  // Connections closed by the peer are not handed out again.
+  udt::connection_pool lasting(io_service);
+  connect(lasting, client, server);
+  lasting.release(client.release());
+  CHECK(lasting.idle() == 1);
+  server.reset();
+  boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
+  connect(lasting, client, server);
+  CHECK(lasting.idle() == 0);
+}
+
+static
+void
+test_broadcast(boost::asio::io_service& io_service)
+{
+  auto live = connect_pair(io_service, 4321);
+  auto closed = connect_pair(io_service, 4322);
+  auto gone = connect_pair(io_service, 4323);
+  auto sent = pattern(4 << 20);
+  auto data = std::make_shared<std::vector<char> const>(sent.begin(),
+                                                        sent.end());
+  udt::broadcast broadcast(io_service);
+  std::vector<boost::system::error_code> errors;
+  bool done = false;
+  // One peer is closed beforehand, another destroyed once the broadcast
+  // is under way: only the live one is served.
+  closed.first->close();
+  broadcast.async_send(
+    data, {live.first.get(), closed.first.get(), gone.first.get()},
+    [&] (std::vector<boost::system::error_code> const& e)
+    {
+      errors = e;
+      done = true;
+    });
+  gone.first.reset();
+  std::string received(sent.size(), 0);
+  read_all(*live.second, received, [] {});
+  io_service.run();
+  io_service.restart();
+  CHECK(done);
+  CHECK(errors.size() == 3);
+  CHECK(!errors[0]);
+  CHECK(errors[1]);
+  CHECK(errors[2] == boost::asio::error::operation_aborted);
+  CHECK(received == sent);
+}
+
+static
+void
+test_timeouts(boost::asio::io_service& io_service)
+{
+  auto peers = connect_pair(io_service, 4324);
+  auto& client = *peers.first;
+  auto& server = *peers.second;
+  char buffer[16];
+  // A stalled read fails with timed_out.
+  server.read_timeout(boost::posix_time::milliseconds(100));
+  boost::system::error_code read_error;
+  server.async_read_some(
+    boost::asio::buffer(buffer),
+    [&] (boost::system::error_code const& error, std::size_t size)
+    {
+      CHECK(size == 0);
+      read_error = error;
+    });
+  io_service.run();
+  io_service.restart();
+  CHECK(read_error == boost::asio::error::timed_out);
+  // A completed read disarms its timer: it does not abort the next read,
+  // though that one outlives it.
+  int reads = 0;
+  server.async_read_some(
+    boost::asio::buffer(buffer),
+    [&] (boost::system::error_code const& error, std::size_t size)
+    {
+      CHECK(!error);
+      CHECK(size == 1);
+      ++reads;
+    });
+  client.async_write_some(
+    boost::asio::buffer("x", 1),
+    [] (boost::system::error_code const& error, std::size_t)
+    {
+      CHECK(!error);
+    });
+  io_service.run();
+  io_service.restart();
+  CHECK(reads == 1);
+  server.read_timeout(boost::posix_time::pos_infin);
+  server.async_read_some(
+    boost::asio::buffer(buffer),
+    [&] (boost::system::error_code const& error, std::size_t size)
+    {
+      CHECK(!error);
+      CHECK(size == 1);
+      ++reads;
+    });
+  boost::asio::deadline_timer later(io_service,
+                                    boost::posix_time::milliseconds(300));
+  later.async_wait(
+    [&] (boost::system::error_code const&)
+    {
+      client.async_write_some(
+        boost::asio::buffer("y", 1),
+        [] (boost::system::error_code const& error, std::size_t)
+        {
+          CHECK(!error);
+        });
+    });
+  io_service.run();
+  io_service.restart();
+  CHECK(reads == 2);
+  // A write stalled by a peer that does not read fails with timed_out.
+  client.write_timeout(boost::posix_time::milliseconds(200));
+  auto chunk = pattern(1 << 20);
+  boost::system::error_code write_error;
+  std::function<void ()> write = [&]
+    {
+      client.async_write_some(
+        boost::asio::buffer(chunk),
+        [&] (boost::system::error_code const& error, std::size_t)
+        {
+          if (error)
+            write_error = error;
+          else
+            write();
+        });
+    };
+  write();
+  io_service.run();
+  io_service.restart();
+  CHECK(write_error == boost::asio::error::timed_out);
+}
+
+/// Read handler counting the invocations through its hook.
+struct hooked_read
+{
+  int* calls;
+  int* hooked;
+
+  void
+  operator ()(boost::system::error_code const& error, std::size_t size)
+  {
+    CHECK(!error);
+    CHECK(size == 1);
+    ++*this->calls;
+  }
+
+  template <typename Function>
+  friend
+  void
+  asio_handler_invoke(Function& function, hooked_read* self)
+  {
+    ++*self->hooked;
+    function();
+  }
+};
+
+static
+void
+test_handler_hooks(boost::asio::io_service& io_service)
+{
+  auto peers = connect_pair(io_service, 4325);
+  auto& client = *peers.first;
+  auto& server = *peers.second;
+  char buffer[1];
+  auto send = [&]
+    {
+      client.async_write_some(
+        boost::asio::buffer("x", 1),
+        [] (boost::system::error_code const& error, std::size_t)
+        {
+          CHECK(!error);
+        });
+    };
+  boost::asio::io_service::strand strand(io_service);
+  int calls = 0;
+  auto on_strand = boost::asio::bind_executor(
+    strand,
+    [&] (boost::system::error_code const& error, std::size_t size)
+    {
+      CHECK(!error);
+      CHECK(size == 1);
+      CHECK(strand.running_in_this_thread());
+      ++calls;
+    });
+  int hooked = 0;
+  int hooked_calls = 0;
+  // Deferred completions: the read waits for data.
+  server.async_read_some(boost::asio::buffer(buffer), on_strand);
+  send();
+  io_service.run();
+  io_service.restart();
+  server.async_read_some(boost::asio::buffer(buffer),
+                         hooked_read{&hooked_calls, &hooked});
+  send();
+  io_service.run();
+  io_service.restart();
+  CHECK(calls == 1);
+  CHECK(hooked_calls == 1 && hooked >= 1);
+  // Immediate completions: data is there already.
+  send();
+  send();
+  io_service.run();
+  io_service.restart();
+  boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+  server.async_read_some(boost::asio::buffer(buffer), on_strand);
+  io_service.run();
+  io_service.restart();
+  hooked = 0;
+  server.async_read_some(boost::asio::buffer(buffer),
+                         hooked_read{&hooked_calls, &hooked});
+  io_service.run();
+  io_service.restart();
+  CHECK(calls == 2);
+  CHECK(hooked_calls == 2 && hooked >= 1);
+}
+
+static
+void
+test_future(boost::asio::io_service& io_service)
+{
+  auto peers = connect_pair(io_service, 4326);
+  auto& client = *peers.first;
+  auto& server = *peers.second;
+  std::unique_ptr<boost::asio::io_service::work> work(
+    new boost::asio::io_service::work(io_service));
+  boost::thread runner([&] { io_service.run(); });
+  char buffer[1];
+  auto read = server.async_read_some(boost::asio::buffer(buffer),
+                                     boost::asio::use_future);
+  auto written = client.async_write_some(boost::asio::buffer("x", 1),
+                                         boost::asio::use_future);
+  CHECK(written.get() == 1);
+  CHECK(read.get() == 1 && buffer[0] == 'x');
+  // Errors are thrown by the future.
+  server.read_timeout(boost::posix_time::milliseconds(50));
+  auto timed_out = server.async_read_some(boost::asio::buffer(buffer),
+                                          boost::asio::use_future);
+  bool thrown = false;
+  try
+  {
+    timed_out.get();
+  }
+  catch (boost::system::system_error const& e)
+  {
+    CHECK(e.code() == boost::asio::error::timed_out);
+    thrown = true;
+  }
+  CHECK(thrown);
+  work.reset();
+  runner.join();
+  io_service.restart();
+}
+
+static
+void
+test_wait(boost::asio::io_service& io_service)
+{
+  auto peers = connect_pair(io_service, 4327);
+  auto& client = *peers.first;
+  auto& server = *peers.second;
+  int ready = 0;
+  // A fresh connection can be written to.
+  client.async_wait(udt::socket::wait_write,
+                    [&] (boost::system::error_code const& error)
+                    {
+                      CHECK(!error);
+                      ++ready;
+                    });
+  io_service.run();
+  io_service.restart();
+  CHECK(ready == 1);
+  // Waiting for data consumes none of it.
+  auto send = [&] (std::string const& data)
+    {
+      client.async_write_some(
+        boost::asio::buffer(data),
+        [] (boost::system::error_code const& error, std::size_t)
+        {
+          CHECK(!error);
+        });
+    };
+  server.async_wait(udt::socket::wait_read,
+                    [&] (boost::system::error_code const& error)
+                    {
+                      CHECK(!error);
+                      ++ready;
+                    });
+  std::string const x("x");
+  send(x);
+  io_service.run();
+  io_service.restart();
+  CHECK(ready == 2);
+  server.async_read_some(
+    boost::asio::null_buffers(),
+    [&] (boost::system::error_code const& error, std::size_t size)
+    {
+      CHECK(!error);
+      CHECK(size == 0);
+      ++ready;
+    });
+  std::string const y("y");
+  send(y);
+  io_service.run();
+  io_service.restart();
+  CHECK(ready == 3);
+  std::string received(2, 0);
+  read_all(server, received, [] {});
+  io_service.run();
+  io_service.restart();
+  CHECK(received == "xy");
+  // Nothing is awaited past shutdown.
+  boost::system::error_code error;
+  server.shutdown(udt::socket::shutdown_receive, error);
+  CHECK(!error);
+  boost::system::error_code eof;
+  server.async_wait(udt::socket::wait_read,
+                    [&] (boost::system::error_code const& error)
+                    {
+                      eof = error;
+                    });
+  io_service.run();
+  io_service.restart();
+  CHECK(eof == boost::asio::error::eof);
+}
+
+static
+void
+test_bandwidth(boost::asio::io_service& io_service)
+{
+  auto& service = boost::asio::use_service<udt::service>(io_service);
+  auto light = connect_pair(io_service, 4328);
+  auto heavy = connect_pair(io_service, 4329);
+  std::int64_t const budget = 4 << 20;
+  service.bandwidth(budget);
+  service.weight(heavy.first.get(), 3);
+  auto sent = pattern(1 << 20);
+  std::string light_received(sent.size(), 0);
+  std::string heavy_received(sent.size(), 0);
+  typedef std::chrono::steady_clock Clock;
+  auto start = Clock::now();
+  Clock::time_point light_done;
+  Clock::time_point heavy_done;
+  // UDT buffers the data sent: time its reception.
+  write_all(*light.first, sent, [] {});
+  write_all(*heavy.first, sent, [] {});
+  read_all(*light.second, light_received,
+           [&] { light_done = Clock::now(); });
+  read_all(*heavy.second, heavy_received,
+           [&] { heavy_done = Clock::now(); });
+  io_service.run();
+  io_service.restart();
+  CHECK(light_received == sent);
+  CHECK(heavy_received == sent);
+  // The heavier sender gets three quarters of the budget, the light one
+  // the rest, then all of it: 2 MB take half a second instead of a few
+  // milliseconds over the loopback.
+  CHECK(heavy_done < light_done);
+  CHECK(light_done - start >= std::chrono::milliseconds(250));
+  service.bandwidth(-1);
+}
+
+static
+void
+test_batch(boost::asio::io_service& io_service)
+{
+  auto& service = boost::asio::use_service<udt::service>(io_service);
+  std::vector<std::pair<Socket, Socket>> peers;
+  for (int port = 4330; port < 4333; ++port)
+    peers.push_back(connect_pair(io_service, port));
+  auto record = std::make_shared<udt::recorder>();
+  service.recorder(record);
+  service.batch(2);
+  char buffer[3];
+  std::vector<std::size_t> order;
+  bool thrown = false;
+  for (int round = 0; round < 3; ++round)
+  {
+    for (std::size_t i = 0; i < peers.size(); ++i)
+      peers[i].second->async_read_some(
+        boost::asio::buffer(buffer + i, 1),
+        [&, i, round] (boost::system::error_code const& error,
+                       std::size_t size)
+        {
+          CHECK(!error);
+          CHECK(size == 1);
+          order.push_back(i);
+          // An exception leaves the rest of the chunk to run later.
+          if (round == 2 && !thrown)
+          {
+            thrown = true;
+            throw std::runtime_error("handler failure");
+          }
+        });
+    for (std::size_t j = 0; j < peers.size(); ++j)
+      peers[(j + round) % peers.size()].first->async_write_some(
+        boost::asio::buffer("x", 1),
+        [] (boost::system::error_code const& error, std::size_t)
+        {
+          CHECK(!error);
+        });
+    while (true)
+      try
+      {
+        io_service.run();
+        io_service.restart();
+        break;
+      }
+      catch (std::runtime_error const&)
+      {
+        io_service.restart();
+      }
+  }
+  service.recorder(nullptr);
+  service.batch(0);
+  CHECK(thrown);
+  CHECK(order.size() == 3 * peers.size());
+  // Handlers run in the order the reactor found their socket ready.
+  std::vector<int> ready;
+  for (auto const& e: record->events())
+    if (e.kind == udt::recorder::ready && e.queue == udt::recorder::read)
+      ready.push_back(e.fd);
+  CHECK(ready.size() == order.size());
+  std::map<int, std::size_t> peer;
+  for (std::size_t i = 0; i < ready.size(); ++i)
+  {
+    auto it = peer.insert(std::make_pair(ready[i], order[i])).first;
+    CHECK(it->second == order[i]);
+  }
+  CHECK(peer.size() == peers.size());
+}
+
+/// Failures are reported through error codes and handlers, never thrown.
+static
+void
+test_error_codes(boost::asio::io_service& io_service)
+{
+  boost::system::error_code error;
+  udt::acceptor listening(io_service);
+  listening.listen(4333, error);
+  CHECK(!error);
+  udt::acceptor duplicate(io_service);
+  duplicate.listen(4333, error);
+  CHECK(error);
+  udt::socket socket(io_service);
+  error.clear();
+  socket.cancel(error);
+  CHECK(!error);
+  socket.close(error);
+  CHECK(!error);
+  socket.close(error);
+  CHECK(error);
+  error.clear();
+  socket.bind(4334, error);
+  CHECK(error);
+  boost::system::error_code connect_error;
+  socket.async_connect(loopback(4333),
+                       [&] (boost::system::error_code const& error)
+                       {
+                         connect_error = error;
+                       });
+  io_service.run();
+  io_service.restart();
+  CHECK(connect_error);
+}
+
+static
+void
+test_busy_poll()
+{
+  boost::asio::io_service io_service;
+  auto service = new udt::service(io_service);
+  boost::asio::add_service(io_service, service);
+  service->busy_poll(std::chrono::microseconds(2000));
+  CHECK(service->busy_poll() == std::chrono::microseconds(2000));
+  // Pinning may be refused, the reactor runs anyway.
+  service->affinity(0);
+  CHECK(service->affinity() == 0);
+  auto peers = connect_pair(io_service, 4335);
+  // Exchanges, some caught while spinning, others after blocking.
+  for (int i = 0; i < 4; ++i)
+  {
+    auto sent = pattern(64 * 1024 << i);
+    std::string received(sent.size(), 0);
+    write_all(*peers.first, sent, [] {});
+    read_all(*peers.second, received, [] {});
+    io_service.run();
+    io_service.restart();
+    CHECK(received == sent);
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+  }
+}
+
+static
+void
+test_system_wait(boost::asio::io_service& io_service)
+{
+  auto& service = boost::asio::use_service<udt::service>(io_service);
+  int fds[2];
+  CHECK(::pipe(fds) == 0);
+  int ready = 0;
+  // A pipe can be written to right away.
+  service.async_wait(fds[1], boost::asio::socket_base::wait_write,
+                     [&] (boost::system::error_code const& error)
+                     {
+                       CHECK(!error);
+                       ++ready;
+                     });
+  io_service.run();
+  io_service.restart();
+  CHECK(ready == 1);
+  // Reads wait for data.
+  service.async_wait(fds[0], boost::asio::socket_base::wait_read,
+                     [&] (boost::system::error_code const& error)
+                     {
+                       CHECK(!error);
+                       ++ready;
+                     });
+  boost::asio::deadline_timer later(io_service,
+                                    boost::posix_time::milliseconds(100));
+  later.async_wait(
+    [&] (boost::system::error_code const&)
+    {
+      CHECK(ready == 1);
+      CHECK(::write(fds[1], "x", 1) == 1);
+    });
+  io_service.run();
+  io_service.restart();
+  CHECK(ready == 2);
+  char c;
+  CHECK(::read(fds[0], &c, 1) == 1 && c == 'x');
+  // Pending waits are cancelled, or time out.
+  boost::system::error_code aborted;
+  auto operation = service.register_system_read(
+    fds[0], [] { CHECK(false); },
+    [&] (boost::system::error_code const& error)
+    {
+      aborted = error;
+    });
+  service.cancel_system_read(fds[0], operation);
+  io_service.run();
+  io_service.restart();
+  CHECK(aborted == boost::asio::error::operation_aborted);
+  boost::system::error_code timed_out;
+  service.register_system_read(
+    fds[0], [] { CHECK(false); },
+    [&] (boost::system::error_code const& error)
+    {
+      timed_out = error;
+    },
+    boost::posix_time::milliseconds(50));
+  io_service.run();
+  io_service.restart();
+  CHECK(timed_out == boost::asio::error::timed_out);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
 int main(int, char** argv)
 {
   try
   {
+    test_timing_wheel();
+    test_buffer_pool();
+    test_histogram();
+    test_crc32c();
+    test_recorder();
+    test_replay();
     boost::asio::io_service io_service;
     boost::asio::add_service(io_service,
                              new boost::asio::ip::udt::service(io_service));
+    test_shutdown(io_service);
+    test_cancel(io_service);
+    test_accept_into(io_service);
+    test_striped(io_service);
+    test_send(io_service);
+#ifdef ASIO_UDT_LZ4
+    test_compressed(io_service);
+#endif
+    test_framed(io_service);
+    test_autotune(io_service);
+    test_file_transfer(io_service);
+    test_anchor(io_service);
+    test_connection_pool(io_service);
+    test_broadcast(io_service);
+    test_timeouts(io_service);
+    test_handler_hooks(io_service);
+    test_future(io_service);
+    test_wait(io_service);
+    test_bandwidth(io_service);
+    test_batch(io_service);
+    test_error_codes(io_service);
+    test_system_wait(io_service);
+    test_polled();
+    test_shared();
+    test_busy_poll();
     EchoServer server(io_service, 4242);
     EchoClient client(io_service, 4242);
 